@@ -0,0 +1,210 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "edgetrigger.h"
+
+#include <KWindowSystem>
+
+#include <QGuiApplication>
+
+#if HAVE_X11
+#include <xcb/xcb_event.h>
+#include <xcb/xinput.h>
+#endif
+
+EdgeTrigger::EdgeTrigger(QObject *parent)
+    : QObject(parent)
+{
+#if HAVE_X11
+    if (!KWindowSystem::isPlatformX11())
+        return;
+
+    auto x11Interface = qGuiApp->nativeInterface<QNativeInterface::QX11Application>();
+
+    if (!x11Interface)
+        return;
+
+    xcb_connection_t *connection = x11Interface->connection();
+
+    // Pointer barriers need XFixes 5, and their events XInput 2.3.
+    const xcb_query_extension_reply_t *xfixesExtension = xcb_get_extension_data(connection, &xcb_xfixes_id);
+    const xcb_query_extension_reply_t *xinputExtension = xcb_get_extension_data(connection, &xcb_input_id);
+
+    if (!xfixesExtension || !xfixesExtension->present || !xinputExtension || !xinputExtension->present)
+        return;
+
+    xcb_xfixes_query_version_reply_t *xfixesVersion =
+        xcb_xfixes_query_version_reply(connection, xcb_xfixes_query_version(connection, 5, 0), nullptr);
+    const bool haveXFixes = xfixesVersion && xfixesVersion->major_version >= 5;
+    free(xfixesVersion);
+
+    xcb_input_xi_query_version_reply_t *xinputVersion =
+        xcb_input_xi_query_version_reply(connection, xcb_input_xi_query_version(connection, 2, 3), nullptr);
+    const bool haveXInput =
+        xinputVersion && (xinputVersion->major_version > 2 || (xinputVersion->major_version == 2 && xinputVersion->minor_version >= 3));
+    free(xinputVersion);
+
+    if (!haveXFixes || !haveXInput)
+        return;
+
+    m_connection = connection;
+    m_rootWindow = xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data->root;
+    m_xinputOpcode = xinputExtension->major_opcode;
+
+    // Barrier events are delivered to the window the barrier was created
+    // on. Selecting for all master devices leaves the mask Qt itself sets
+    // on the root window for all devices alone.
+    struct {
+        xcb_input_event_mask_t header;
+        uint32_t mask;
+    } eventMask = {{XCB_INPUT_DEVICE_ALL_MASTER, 1}, XCB_INPUT_XI_EVENT_MASK_BARRIER_HIT};
+
+    xcb_input_xi_select_events(m_connection, m_rootWindow, 1, &eventMask.header);
+    xcb_flush(m_connection);
+
+    qGuiApp->installNativeEventFilter(this);
+#endif
+}
+
+EdgeTrigger::~EdgeTrigger()
+{
+    destroyBarriers();
+}
+
+bool EdgeTrigger::isSupported() const
+{
+#if HAVE_X11
+    return m_connection != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool EdgeTrigger::isEnabled() const
+{
+    return m_enabled;
+}
+
+void EdgeTrigger::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+
+    m_enabled = enabled;
+
+    if (!m_enabled) {
+        destroyBarriers();
+        return;
+    }
+
+#if HAVE_X11
+    if (!m_connection)
+        return;
+
+    for (const QRect &area : std::as_const(m_areas)) {
+        if (area.isEmpty())
+            continue;
+
+        const xcb_xfixes_barrier_t barrier = xcb_generate_id(m_connection);
+
+        // A horizontal barrier along the top of the area that only lets the
+        // pointer pass downwards. Where no other screen lies above, the
+        // screen edge stops the pointer going up anyway; elsewhere it is
+        // let through on the first hit.
+        xcb_xfixes_create_pointer_barrier(m_connection,
+                                          barrier,
+                                          m_rootWindow,
+                                          area.left(),
+                                          area.top(),
+                                          area.right(),
+                                          area.top(),
+                                          XCB_XFIXES_BARRIER_DIRECTIONS_POSITIVE_Y,
+                                          0,
+                                          nullptr);
+
+        m_barriers << barrier;
+    }
+
+    xcb_flush(m_connection);
+#endif
+}
+
+void EdgeTrigger::setAreas(const QList<QRect> &areas)
+{
+    if (m_areas == areas)
+        return;
+
+    m_areas = areas;
+
+    if (m_enabled) {
+        setEnabled(false);
+        setEnabled(true);
+    }
+}
+
+bool EdgeTrigger::nativeEventFilter(const QByteArray &eventType, void *message, qintptr *result)
+{
+    Q_UNUSED(result);
+
+#if HAVE_X11
+    if (!m_enabled || eventType != "xcb_generic_event_t")
+        return false;
+
+    auto event = static_cast<xcb_generic_event_t *>(message);
+
+    if (XCB_EVENT_RESPONSE_TYPE(event) != XCB_GE_GENERIC)
+        return false;
+
+    auto hitEvent = reinterpret_cast<xcb_input_barrier_hit_event_t *>(event);
+
+    if (hitEvent->extension != m_xinputOpcode || hitEvent->event_type != XCB_INPUT_BARRIER_HIT)
+        return false;
+
+    if (!m_barriers.contains(hitEvent->barrier))
+        return false;
+
+    // The server keeps sending hits with the same event id for as long as
+    // the pointer is pushed against the barrier; trigger once per push.
+    if (hitEvent->eventid != m_lastEventId) {
+        m_lastEventId = hitEvent->eventid;
+
+        xcb_input_barrier_release_pointer_info_t releaseInfo = {};
+        releaseInfo.deviceid = hitEvent->deviceid;
+        releaseInfo.barrier = hitEvent->barrier;
+        releaseInfo.eventid = hitEvent->eventid;
+
+        xcb_input_xi_barrier_release_pointer(m_connection, 1, &releaseInfo);
+        xcb_flush(m_connection);
+
+        // Queued, so the barriers aren't destroyed from within the event filter.
+        QMetaObject::invokeMethod(this, &EdgeTrigger::triggered, Qt::QueuedConnection);
+    }
+
+    return true;
+#else
+    Q_UNUSED(eventType);
+    Q_UNUSED(message);
+
+    return false;
+#endif
+}
+
+void EdgeTrigger::destroyBarriers()
+{
+#if HAVE_X11
+    if (!m_connection || m_barriers.isEmpty())
+        return;
+
+    for (xcb_xfixes_barrier_t barrier : std::as_const(m_barriers))
+        xcb_xfixes_delete_pointer_barrier(m_connection, barrier);
+
+    m_barriers.clear();
+
+    xcb_flush(m_connection);
+#endif
+}
+
+#include "moc_edgetrigger.cpp"
@@ -0,0 +1,74 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef EDGETRIGGER_H
+#define EDGETRIGGER_H
+
+#include <config-yakuake.h>
+
+#include <QAbstractNativeEventFilter>
+#include <QList>
+#include <QObject>
+#include <QRect>
+
+#if HAVE_X11
+#include <xcb/xcb.h>
+#include <xcb/xfixes.h>
+#endif
+
+/**
+ * Reports the mouse pointer entering areas at the edge of the screen
+ * without polling its position.
+ *
+ * On X11 every area is lined with an XFixes pointer barrier along the
+ * screen edge, so the X server wakes us up with an XInput BarrierHit
+ * event when the pointer is pushed against it. The pointer is released
+ * right away, so an edge shared with a screen above can still be crossed. Unlike a window covering
+ * the area, a barrier takes no input and can't end up stacked below
+ * other windows. Other platforms, and X servers without XFixes 5 and
+ * XInput 2.3, are not supported; callers should check isSupported()
+ * and fall back to polling.
+ */
+class EdgeTrigger : public QObject, public QAbstractNativeEventFilter
+{
+    Q_OBJECT
+
+public:
+    explicit EdgeTrigger(QObject *parent = nullptr);
+    ~EdgeTrigger() override;
+
+    bool isSupported() const;
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /**
+     * Sets the trigger areas, in native screen coordinates.
+     */
+    void setAreas(const QList<QRect> &areas);
+
+Q_SIGNALS:
+    void triggered();
+
+protected:
+    bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *result) override;
+
+private:
+    void destroyBarriers();
+
+    QList<QRect> m_areas;
+    bool m_enabled = false;
+
+#if HAVE_X11
+    xcb_connection_t *m_connection = nullptr;
+    xcb_window_t m_rootWindow = XCB_WINDOW_NONE;
+    uint8_t m_xinputOpcode = 0;
+    QList<xcb_xfixes_barrier_t> m_barriers;
+    uint32_t m_lastEventId = 0;
+#endif
+};
+
+#endif
@@ -0,0 +1,416 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "layouttree.h"
+
+int LayoutTree::Node::indexOf(const Node *child) const
+{
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i].get() == child)
+            return int(i);
+    }
+
+    return -1;
+}
+
+LayoutTree::LayoutTree()
+    : m_root(std::make_unique<Node>())
+{
+}
+
+LayoutTree::~LayoutTree() = default;
+
+QList<int> LayoutTree::terminalIds() const
+{
+    QList<int> terminalIds;
+    terminalIds.reserve(m_terminals.size());
+
+    collectTerminalIds(m_root.get(), terminalIds);
+
+    return terminalIds;
+}
+
+void LayoutTree::collectTerminalIds(const Node *node, QList<int> &terminalIds) const
+{
+    if (node->isTerminal()) {
+        terminalIds << node->terminalId;
+        return;
+    }
+
+    for (const std::unique_ptr<Node> &child : node->children)
+        collectTerminalIds(child.get(), terminalIds);
+}
+
+QHash<int, QRectF> LayoutTree::terminalRects() const
+{
+    QHash<int, QRectF> rects;
+    rects.reserve(m_terminals.size());
+
+    collectTerminalRects(m_root.get(), QRectF(0, 0, 1, 1), rects);
+
+    return rects;
+}
+
+void LayoutTree::collectTerminalRects(const Node *node, const QRectF &rect, QHash<int, QRectF> &rects) const
+{
+    if (node->isTerminal()) {
+        rects.insert(node->terminalId, rect);
+        return;
+    }
+
+    const int count = node->children.size();
+    const bool knownSizes = (node->sizes.count() == count);
+
+    qreal total = 0;
+
+    for (int i = 0; i < count; ++i)
+        total += knownSizes ? qMax(node->sizes.at(i), 0) : 1;
+
+    qreal offset = 0;
+
+    for (int i = 0; i < count; ++i) {
+        const qreal share = (total > 0) ? (knownSizes ? qMax(node->sizes.at(i), 0) : 1) / total : 0;
+        QRectF childRect = rect;
+
+        if (node->orientation == Qt::Horizontal) {
+            childRect.setLeft(rect.left() + offset * rect.width());
+            childRect.setWidth(share * rect.width());
+        } else {
+            childRect.setTop(rect.top() + offset * rect.height());
+            childRect.setHeight(share * rect.height());
+        }
+
+        offset += share;
+
+        collectTerminalRects(node->children[i].get(), childRect, rects);
+    }
+}
+
+static qreal overlap(qreal start1, qreal end1, qreal start2, qreal end2)
+{
+    return qMin(end1, end2) - qMax(start1, start2);
+}
+
+QHash<int, LayoutTree::Neighbors> LayoutTree::neighbors() const
+{
+    const qreal epsilon = 1e-6;
+
+    const QHash<int, QRectF> rects = terminalRects();
+    QHash<int, Neighbors> neighbors;
+    neighbors.reserve(rects.size());
+
+    // How well a candidate fits as the neighbor of a terminal along an edge.
+    auto score = [](qreal start, qreal end, qreal candidateStart, qreal candidateEnd) {
+        const qreal middle = (start + end) / 2;
+        const bool facesMiddle = (candidateStart <= middle && middle < candidateEnd);
+
+        return (facesMiddle ? 1.0 : 0.0) + overlap(start, end, candidateStart, candidateEnd);
+    };
+
+    for (auto it = rects.cbegin(); it != rects.cend(); ++it) {
+        const QRectF &rect = it.value();
+
+        Neighbors &entry = neighbors[it.key()];
+        qreal upScore = 0, rightScore = 0, downScore = 0, leftScore = 0;
+
+        for (auto candidate = rects.cbegin(); candidate != rects.cend(); ++candidate) {
+            if (candidate.key() == it.key())
+                continue;
+
+            const QRectF &other = candidate.value();
+
+            if (overlap(rect.top(), rect.bottom(), other.top(), other.bottom()) > epsilon) {
+                const qreal fit = score(rect.top(), rect.bottom(), other.top(), other.bottom());
+
+                if (qAbs(other.left() - rect.right()) < epsilon && fit > rightScore) {
+                    entry.right = candidate.key();
+                    rightScore = fit;
+                } else if (qAbs(other.right() - rect.left()) < epsilon && fit > leftScore) {
+                    entry.left = candidate.key();
+                    leftScore = fit;
+                }
+            }
+
+            if (overlap(rect.left(), rect.right(), other.left(), other.right()) > epsilon) {
+                const qreal fit = score(rect.left(), rect.right(), other.left(), other.right());
+
+                if (qAbs(other.top() - rect.bottom()) < epsilon && fit > downScore) {
+                    entry.down = candidate.key();
+                    downScore = fit;
+                } else if (qAbs(other.bottom() - rect.top()) < epsilon && fit > upScore) {
+                    entry.up = candidate.key();
+                    upScore = fit;
+                }
+            }
+        }
+    }
+
+    return neighbors;
+}
+
+static QList<int> scaledSizes(const QList<qreal> &weights)
+{
+    // Only the proportions matter, splitters share out their actual extent
+    // by the relative weight of their sizes.
+    const int scale = 10000;
+
+    qreal total = 0;
+
+    for (qreal weight : weights)
+        total += weight;
+
+    QList<int> sizes;
+    sizes.reserve(weights.count());
+
+    for (qreal weight : weights)
+        sizes << ((total > 0) ? qRound(weight / total * scale) : (scale / weights.count()));
+
+    return sizes;
+}
+
+void LayoutTree::rebalance(Balance balance, int focusTerminalId, const QHash<int, qreal> &weights)
+{
+    balanceSizes(m_root.get(), (balance == Weighted) ? weights : QHash<int, qreal>());
+
+    if (balance != GoldenRatio)
+        return;
+
+    // 1/phi, leaving the siblings 1/phi^2 to share.
+    const qreal share = 0.618034;
+
+    Node *child = terminalNode(focusTerminalId);
+
+    for (Node *split = child ? child->parent : nullptr; split; child = split, split = split->parent) {
+        const int index = split->indexOf(child);
+        const int count = split->sizes.count();
+
+        if (count < 2 || index == -1)
+            continue;
+
+        qreal others = 0;
+
+        for (int i = 0; i < count; ++i) {
+            if (i != index)
+                others += split->sizes.at(i);
+        }
+
+        QList<qreal> goldenWeights;
+
+        for (int i = 0; i < count; ++i) {
+            if (i == index)
+                goldenWeights << share;
+            else
+                goldenWeights << ((others > 0) ? split->sizes.at(i) / others : 1.0 / (count - 1)) * (1 - share);
+        }
+
+        split->sizes = scaledSizes(goldenWeights);
+    }
+}
+
+QSizeF LayoutTree::balanceSizes(Node *node, const QHash<int, qreal> &weights)
+{
+    // How many terminals (or how much weight) a node holds side by side
+    // along either axis.
+    if (node->isTerminal()) {
+        qreal weight = weights.value(node->terminalId, 1);
+
+        if (weight <= 0)
+            weight = 1;
+
+        return QSizeF(weight, weight);
+    }
+
+    QList<qreal> childWeights;
+    QSizeF extent(0, 0);
+
+    for (const std::unique_ptr<Node> &child : node->children) {
+        const QSizeF childExtent = balanceSizes(child.get(), weights);
+
+        if (node->orientation == Qt::Horizontal) {
+            childWeights << childExtent.width();
+            extent.rwidth() += childExtent.width();
+            extent.setHeight(qMax(extent.height(), childExtent.height()));
+        } else {
+            childWeights << childExtent.height();
+            extent.rheight() += childExtent.height();
+            extent.setWidth(qMax(extent.width(), childExtent.width()));
+        }
+    }
+
+    if (!childWeights.isEmpty())
+        node->sizes = scaledSizes(childWeights);
+
+    return extent;
+}
+
+LayoutTree::Node *LayoutTree::addTerminal(Node *split, int terminalId)
+{
+    auto node = std::make_unique<Node>();
+    node->terminalId = terminalId;
+
+    m_terminals.insert(terminalId, node.get());
+
+    return append(split, std::move(node));
+}
+
+LayoutTree::Node *LayoutTree::addSplit(Node *split, Qt::Orientation orientation)
+{
+    auto node = std::make_unique<Node>();
+    node->orientation = orientation;
+
+    return append(split, std::move(node));
+}
+
+LayoutTree::Node *LayoutTree::wrapInSplit(Node *node, Qt::Orientation orientation)
+{
+    Node *parent = node->parent;
+    std::unique_ptr<Node> &slot = parent->children[parent->indexOf(node)];
+
+    auto split = std::make_unique<Node>();
+    split->orientation = orientation;
+    split->parent = parent;
+
+    // The split takes over the node's place and thereby its size.
+    std::unique_ptr<Node> wrapped = std::move(slot);
+    slot = std::move(split);
+
+    return append(slot.get(), std::move(wrapped));
+}
+
+LayoutTree::Node *LayoutTree::removeTerminal(int terminalId, std::vector<std::unique_ptr<Node>> &removedSplits)
+{
+    Node *node = m_terminals.take(terminalId);
+
+    if (!node)
+        return nullptr;
+
+    Node *split = node->parent;
+    take(node);
+
+    // Only the ancestors of the terminal can have been left empty.
+    while (split != m_root.get() && split->children.empty()) {
+        Node *parent = split->parent;
+        removedSplits.push_back(take(split));
+        split = parent;
+    }
+
+    if (split->children.size() != 1)
+        return split;
+
+    if (split != m_root.get()) {
+        Node *parent = split->parent;
+        flatten(split, removedSplits);
+
+        return parent;
+    }
+
+    Node *child = split->children.front().get();
+
+    if (child->isTerminal())
+        return split;
+
+    // The root stands for the session's widget, so instead of being
+    // replaced it takes over the children of its only child.
+    std::unique_ptr<Node> taken = take(child);
+
+    m_root->orientation = taken->orientation;
+    m_root->sizes = taken->sizes;
+
+    for (std::unique_ptr<Node> &grandChild : taken->children) {
+        grandChild->parent = m_root.get();
+        m_root->children.push_back(std::move(grandChild));
+    }
+
+    taken->children.clear();
+    removedSplits.push_back(std::move(taken));
+
+    return m_root.get();
+}
+
+void LayoutTree::flatten(Node *split, std::vector<std::unique_ptr<Node>> &removedSplits)
+{
+    Node *parent = split->parent;
+    const int index = parent->indexOf(split);
+
+    // The child takes over the split's place and thereby its size.
+    std::unique_ptr<Node> child = std::move(split->children.front());
+    split->children.clear();
+    child->parent = parent;
+
+    removedSplits.push_back(std::move(parent->children[index]));
+    parent->children[index] = std::move(child);
+
+    const Node *replacement = parent->children[index].get();
+
+    if (!replacement->isTerminal() && replacement->orientation == parent->orientation)
+        merge(parent, index, removedSplits);
+}
+
+void LayoutTree::merge(Node *split, int index, std::vector<std::unique_ptr<Node>> &removedSplits)
+{
+    std::unique_ptr<Node> child = std::move(split->children[index]);
+    split->children.erase(split->children.begin() + index);
+
+    const int count = child->children.size();
+    const bool knownSizes = (split->sizes.count() == int(split->children.size()) + 1);
+    const bool knownChildSizes = (child->sizes.count() == count);
+
+    QList<int> sizes;
+
+    if (knownSizes) {
+        // Share the child's space among its children as before.
+        const int size = split->sizes.takeAt(index);
+        qint64 total = 0;
+
+        for (int i = 0; i < count; ++i)
+            total += knownChildSizes ? child->sizes.at(i) : 1;
+
+        for (int i = 0; i < count; ++i)
+            sizes << ((total > 0) ? int(qint64(size) * (knownChildSizes ? child->sizes.at(i) : 1) / total) : 0);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        child->children[i]->parent = split;
+        split->children.insert(split->children.begin() + index + i, std::move(child->children[i]));
+
+        if (knownSizes)
+            split->sizes.insert(index + i, sizes.at(i));
+    }
+
+    if (!knownSizes)
+        split->sizes.clear();
+
+    child->children.clear();
+    removedSplits.push_back(std::move(child));
+}
+
+LayoutTree::Node *LayoutTree::append(Node *split, std::unique_ptr<Node> node)
+{
+    // The shares of the existing children are no longer known.
+    split->sizes.clear();
+
+    node->parent = split;
+    split->children.push_back(std::move(node));
+
+    return split->children.back().get();
+}
+
+std::unique_ptr<LayoutTree::Node> LayoutTree::take(Node *node)
+{
+    Node *parent = node->parent;
+    const int index = parent->indexOf(node);
+
+    if (parent->sizes.count() == int(parent->children.size()))
+        parent->sizes.removeAt(index);
+    else
+        parent->sizes.clear();
+
+    std::unique_ptr<Node> taken = std::move(parent->children[index]);
+    parent->children.erase(parent->children.begin() + index);
+    taken->parent = nullptr;
+
+    return taken;
+}
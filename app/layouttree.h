@@ -0,0 +1,126 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef LAYOUTTREE_H
+#define LAYOUTTREE_H
+
+#include <QHash>
+#include <QList>
+#include <QRectF>
+#include <QSizeF>
+#include <QtCore/qnamespace.h>
+
+#include <memory>
+#include <vector>
+
+/**
+ * The split layout of a session: splits with an orientation and the
+ * relative sizes of their children, and terminals as the leaves.
+ *
+ * This is plain data without any widgets, Session keeps its Splitter
+ * widgets in line with it.
+ */
+class LayoutTree
+{
+public:
+    enum Balance {
+        Equal,
+        GoldenRatio,
+        Weighted,
+    };
+
+    struct Node {
+        Node *parent = nullptr;
+        std::vector<std::unique_ptr<Node>> children;
+
+        // Splits only. Sizes may be empty, meaning equal shares.
+        Qt::Orientation orientation = Qt::Horizontal;
+        QList<int> sizes;
+
+        // Terminals only.
+        int terminalId = -1;
+
+        bool isTerminal() const
+        {
+            return terminalId != -1;
+        }
+
+        int indexOf(const Node *child) const;
+    };
+
+    LayoutTree();
+    ~LayoutTree();
+
+    Node *root() const
+    {
+        return m_root.get();
+    }
+
+    Node *terminalNode(int terminalId) const
+    {
+        return m_terminals.value(terminalId);
+    }
+
+    // The terminals in layout order, i.e. left to right and top to bottom.
+    QList<int> terminalIds() const;
+
+    // Where each terminal is, as a fraction of the session's area.
+    QHash<int, QRectF> terminalRects() const;
+
+    struct Neighbors {
+        int up = -1;
+        int right = -1;
+        int down = -1;
+        int left = -1;
+    };
+
+    /**
+     * For every terminal, the terminal across each of its edges or -1.
+     * Where several terminals share an edge, the one facing the middle
+     * of the edge wins, otherwise the one sharing most of it.
+     */
+    QHash<int, Neighbors> neighbors() const;
+
+    Node *addTerminal(Node *split, int terminalId);
+    Node *addSplit(Node *split, Qt::Orientation orientation);
+
+    // Puts a split in the place of @p node and moves @p node into it.
+    Node *wrapInSplit(Node *node, Qt::Orientation orientation);
+
+    /**
+     * Removes the terminal and collapses its ancestors so the tree stays
+     * shallow: splits left empty are removed, a split left with a single
+     * child is replaced by that child, and a split ending up inside a
+     * split of the same orientation is merged into it.
+     *
+     * Returns the split whose children changed, if any, and appends the
+     * splits that were removed to @p removedSplits.
+     */
+    Node *removeTerminal(int terminalId, std::vector<std::unique_ptr<Node>> &removedSplits);
+
+    /**
+     * Recomputes the sizes of all splits in one pass. Equal gives every
+     * terminal in a row or column the same extent, Weighted shares the
+     * extent out by @p weights (1 for terminals without one) and
+     * GoldenRatio is Equal, except that the splits on the way to
+     * @p focusTerminalId give it the golden share of their space.
+     */
+    void rebalance(Balance balance, int focusTerminalId = -1, const QHash<int, qreal> &weights = QHash<int, qreal>());
+
+private:
+    Node *append(Node *split, std::unique_ptr<Node> node);
+    std::unique_ptr<Node> take(Node *node);
+    void flatten(Node *split, std::vector<std::unique_ptr<Node>> &removedSplits);
+    void merge(Node *split, int index, std::vector<std::unique_ptr<Node>> &removedSplits);
+    void collectTerminalIds(const Node *node, QList<int> &terminalIds) const;
+    void collectTerminalRects(const Node *node, const QRectF &rect, QHash<int, QRectF> &rects) const;
+    QSizeF balanceSizes(Node *node, const QHash<int, qreal> &weights);
+
+    std::unique_ptr<Node> m_root;
+    QHash<int, Node *> m_terminals;
+};
+
+#endif
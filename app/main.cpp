@@ -13,6 +13,8 @@
 
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
 
 int main(int argc, char *argv[])
 {
@@ -51,6 +53,11 @@ int main(int argc, char *argv[])
     KAboutData::setApplicationData(aboutData);
     QCommandLineParser parser;
 
+    QCommandLineOption layoutOption(QStringLiteral("layout"),
+                                    i18nc("@info:shell", "Open a new session laid out as described in the given JSON file."),
+                                    i18nc("@info:shell", "file"));
+    parser.addOption(layoutOption);
+
     aboutData.setupCommandLine(&parser);
     parser.process(app);
     aboutData.processCommandLine(&parser);
@@ -62,7 +69,31 @@ int main(int argc, char *argv[])
     KCrash::initialize();
     MainWindow mainWindow;
     mainWindow.hide();
-    QObject::connect(&service, &KDBusService::activateRequested, &mainWindow, &MainWindow::toggleWindowState);
+
+    auto addSessionWithLayout = [&mainWindow, &parser, &layoutOption](const QString &workingDirectory) {
+        QFile file(QDir(workingDirectory).absoluteFilePath(parser.value(layoutOption)));
+
+        if (file.open(QIODevice::ReadOnly))
+            mainWindow.addSessionWithLayout(QString::fromUtf8(file.readAll()));
+    };
+
+    if (parser.isSet(layoutOption))
+        addSessionWithLayout(QDir::currentPath());
+
+    QObject::connect(&service,
+                     &KDBusService::activateRequested,
+                     &mainWindow,
+                     [&mainWindow, &parser, &layoutOption, addSessionWithLayout](const QStringList &arguments, const QString &workingDirectory) {
+                         // Starting Yakuake again with a layout adds it to the running instance.
+                         if (parser.parse(arguments) && parser.isSet(layoutOption)) {
+                             addSessionWithLayout(workingDirectory);
+
+                             if (mainWindow.isVisible())
+                                 return;
+                         }
+
+                         mainWindow.toggleWindowState();
+                     });
 
     return app.exec();
 }
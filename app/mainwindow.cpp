@@ -9,14 +9,17 @@
 #include "mainwindow.h"
 #include "config/appearancesettings.h"
 #include "config/windowsettings.h"
+#include "edgetrigger.h"
 #include "firstrundialog.h"
 #include "sessionstack.h"
+#include "sessionstore.h"
 #include "settings.h"
 #include "skin.h"
 #include "tabbar.h"
 #include "terminal.h"
 #include "titlebar.h"
 #include "ui_behaviorsettings.h"
+#include "workareacache.h"
 
 #include <KAboutData>
 #include <KActionCollection>
@@ -38,9 +41,14 @@
 #include <KX11Extras>
 
 #include <QApplication>
+#include <QDBusArgument>
 #include <QDBusConnection>
+#include <QDBusError>
 #include <QDBusPendingReply>
 #include <QDBusReply>
+#include <QDBusServiceWatcher>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QMenu>
 #include <QPainter>
 #include <QScreen>
@@ -96,6 +104,17 @@ MainWindow::MainWindow(QWidget *parent)
 
     m_outputOrderWatcher = OutputOrderWatcher::instance(this);
 
+#if HAVE_X11
+    if (m_isX11) {
+        // KWin announces its slide effect by setting _KDE_SLIDE on the root
+        // window; keep track of it instead of probing on every toggle.
+        m_kdeSlideAtom = XInternAtom(QX11Info::display(), "_KDE_SLIDE", false);
+
+        if (auto x11OutputOrderWatcher = qobject_cast<X11OutputOrderWatcher *>(m_outputOrderWatcher))
+            x11OutputOrderWatcher->watchRootProperty(m_kdeSlideAtom);
+    }
+#endif
+
     setupActions();
     setupMenu();
 
@@ -114,21 +133,93 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_sessionStack, &SessionStack::sessionAdded, m_tabBar, &TabBar::addTab);
     connect(m_sessionStack, &SessionStack::sessionRaised, m_tabBar, &TabBar::selectTab);
     connect(m_sessionStack, &SessionStack::sessionRemoved, m_tabBar, &TabBar::removeTab);
+    connect(m_sessionStack, &SessionStack::sessionClosableChanged, m_tabBar, &TabBar::setTabClosable);
     connect(m_sessionStack, &SessionStack::activeTitleChanged, m_titleBar, &TitleBar::setTitle);
     connect(m_sessionStack, &SessionStack::activeTitleChanged, this, &MainWindow::setWindowTitle);
     connect(m_sessionStack, &SessionStack::wantsBlurChanged, this, &MainWindow::applyWindowProperties);
 
+    // Keep the saved session tree up to date with every change to it.
+    m_sessionStore = new SessionStore(this);
+
+    connect(m_sessionStack, &SessionStack::sessionAdded, m_sessionStore, &SessionStore::scheduleSave);
+    connect(m_sessionStack, &SessionStack::sessionRaised, m_sessionStore, &SessionStore::scheduleSave);
+    connect(m_sessionStack, &SessionStack::sessionRemoved, m_sessionStore, &SessionStore::scheduleSave);
+    connect(m_sessionStack, &SessionStack::sessionChanged, m_sessionStore, &SessionStore::scheduleSave);
+    connect(m_sessionStack, &SessionStack::sessionClosableChanged, m_sessionStore, &SessionStore::scheduleSave);
+    connect(m_sessionStack, &SessionStack::titleChanged, m_sessionStore, &SessionStore::scheduleSave);
+    connect(m_tabBar, &TabBar::tabTitleEdited, m_sessionStore, &SessionStore::scheduleSave);
+    connect(m_tabBar, &TabBar::tabMoved, m_sessionStore, &SessionStore::scheduleSave);
+
     connect(&m_mousePoller, &QTimer::timeout, this, &MainWindow::pollMouse);
 
+    // Where the window system can tell us about the pointer reaching the
+    // screen edge, auto-open doesn't need to poll the pointer position.
+    m_edgeTrigger = new EdgeTrigger(this);
+
+    if (m_edgeTrigger->isSupported()) {
+        connect(m_edgeTrigger, &EdgeTrigger::triggered, this, [this]() {
+            if (!isVisible())
+                toggleWindowState();
+        });
+        connect(m_outputOrderWatcher, &OutputOrderWatcher::outputOrderChanged, this, &MainWindow::updateEdgeTrigger);
+    } else {
+        delete m_edgeTrigger;
+        m_edgeTrigger = nullptr;
+    }
+
     if (KWindowSystem::isPlatformX11()) {
+        // Needs to be created before connecting to workAreaChanged, so the
+        // cached work areas are dropped before the geometry is reapplied.
+        m_workAreaCache = new WorkAreaCache(this);
+
         connect(KX11Extras::self(), &KX11Extras::workAreaChanged, this, &MainWindow::applyWindowGeometry);
     }
 
     connect(m_outputOrderWatcher, &OutputOrderWatcher::outputOrderChanged, this, &MainWindow::updateScreenMenu);
 
+    // KWin's active output follows the pointer or the active window, so
+    // re-resolve it in the background whenever one of those may have moved.
+    m_activeScreenRefreshTimer.setSingleShot(true);
+    m_activeScreenRefreshTimer.setInterval(100);
+    connect(&m_activeScreenRefreshTimer, &QTimer::timeout, this, &MainWindow::refreshActiveScreen);
+    connect(m_outputOrderWatcher, &OutputOrderWatcher::outputOrderChanged, this, &MainWindow::scheduleActiveScreenRefresh);
+
+    if (m_isWayland) {
+        // The work area is only known to plasmashell on Wayland. Keep it around
+        // for every output so opening the window doesn't have to wait for it.
+        auto watchScreen = [this](QScreen *screen) {
+            connect(screen, &QScreen::geometryChanged, this, &MainWindow::refreshAvailableScreenRects);
+        };
+
+        const auto screens = QGuiApplication::screens();
+
+        for (QScreen *screen : screens)
+            watchScreen(screen);
+
+        connect(qGuiApp, &QGuiApplication::screenAdded, this, watchScreen);
+        connect(m_outputOrderWatcher, &OutputOrderWatcher::outputOrderChanged, this, &MainWindow::refreshAvailableScreenRects);
+
+        auto plasmaShellWatcher = new QDBusServiceWatcher(QStringLiteral("org.kde.plasmashell"),
+                                                          QDBusConnection::sessionBus(),
+                                                          QDBusServiceWatcher::WatchForRegistration,
+                                                          this);
+        connect(plasmaShellWatcher, &QDBusServiceWatcher::serviceRegistered, this, &MainWindow::refreshAvailableScreenRects);
+
+        refreshAvailableScreenRects();
+    }
+
+    if (KWindowSystem::isPlatformX11()) {
+        connect(KX11Extras::self(), &KX11Extras::activeWindowChanged, this, [this]() {
+            // While open the window stays on the screen it was opened on.
+            if (!isVisible())
+                scheduleActiveScreenRefresh();
+        });
+    }
+
     applySettings();
 
-    m_sessionStack->addSession();
+    if (!restoreSessions())
+        m_sessionStack->addSession();
 
     if (Settings::firstRun()) {
         QMetaObject::invokeMethod(this, "toggleWindowState", Qt::QueuedConnection);
@@ -146,6 +237,8 @@ MainWindow::~MainWindow()
 {
     Settings::self()->save();
 
+    m_sessionStore->save();
+
     delete m_skin;
 }
 
@@ -387,6 +480,55 @@ void MainWindow::setupActions()
     });
     m_contextDependentActions << action;
 
+    action = actionCollection()->addAction(QStringLiteral("focus-terminal-left"));
+    action->setText(xi18nc("@action", "Focus Terminal to the Left"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("arrow-left")));
+    connect(action, &QAction::triggered, this, [this]() {
+        handleContextDependentAction();
+    });
+    m_contextDependentActions << action;
+
+    action = actionCollection()->addAction(QStringLiteral("focus-terminal-right"));
+    action->setText(xi18nc("@action", "Focus Terminal to the Right"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("arrow-right")));
+    connect(action, &QAction::triggered, this, [this]() {
+        handleContextDependentAction();
+    });
+    m_contextDependentActions << action;
+
+    action = actionCollection()->addAction(QStringLiteral("focus-terminal-up"));
+    action->setText(xi18nc("@action", "Focus Terminal Above"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("arrow-up")));
+    connect(action, &QAction::triggered, this, [this]() {
+        handleContextDependentAction();
+    });
+    m_contextDependentActions << action;
+
+    action = actionCollection()->addAction(QStringLiteral("focus-terminal-down"));
+    action->setText(xi18nc("@action", "Focus Terminal Below"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("arrow-down")));
+    connect(action, &QAction::triggered, this, [this]() {
+        handleContextDependentAction();
+    });
+    m_contextDependentActions << action;
+
+    action = actionCollection()->addAction(QStringLiteral("toggle-terminal-zoom"));
+    action->setText(xi18nc("@action", "Zoom Terminal"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("zoom-fit-best")));
+    actionCollection()->setDefaultShortcut(action, QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_E));
+    connect(action, &QAction::triggered, this, [this]() {
+        handleContextDependentAction();
+    });
+    m_contextDependentActions << action;
+
+    action = actionCollection()->addAction(QStringLiteral("rebalance-terminals"));
+    action->setText(xi18nc("@action", "Balance Terminal Sizes"));
+    action->setIcon(QIcon::fromTheme(QStringLiteral("distribute-horizontal-equal")));
+    connect(action, &QAction::triggered, this, [this]() {
+        handleContextDependentAction();
+    });
+    m_contextDependentActions << action;
+
     action = actionCollection()->addAction(QStringLiteral("rename-session"));
     action->setText(xi18nc("@action", "Rename Session..."));
     action->setIcon(QIcon::fromTheme(QStringLiteral("edit-rename")));
@@ -551,6 +693,24 @@ void MainWindow::handleContextDependentAction(QAction *action, int sessionId)
 
     if (action == actionCollection()->action(QStringLiteral("grow-terminal-bottom")))
         m_sessionStack->tryGrowTerminalBottom(m_sessionStack->activeTerminalId());
+
+    if (action == actionCollection()->action(QStringLiteral("focus-terminal-left")))
+        m_sessionStack->focusTerminalLeft(m_sessionStack->activeTerminalId());
+
+    if (action == actionCollection()->action(QStringLiteral("focus-terminal-right")))
+        m_sessionStack->focusTerminalRight(m_sessionStack->activeTerminalId());
+
+    if (action == actionCollection()->action(QStringLiteral("focus-terminal-up")))
+        m_sessionStack->focusTerminalUp(m_sessionStack->activeTerminalId());
+
+    if (action == actionCollection()->action(QStringLiteral("focus-terminal-down")))
+        m_sessionStack->focusTerminalDown(m_sessionStack->activeTerminalId());
+
+    if (action == actionCollection()->action(QStringLiteral("toggle-terminal-zoom")))
+        m_sessionStack->toggleTerminalZoom(m_sessionStack->activeTerminalId());
+
+    if (action == actionCollection()->action(QStringLiteral("rebalance-terminals")))
+        m_sessionStack->rebalanceSession(sessionId);
 }
 
 void MainWindow::handleContextDependentToggleAction(bool checked, QAction *action, int sessionId)
@@ -563,14 +723,9 @@ void MainWindow::handleContextDependentToggleAction(bool checked, QAction *actio
     if (!action)
         action = qobject_cast<QAction *>(QObject::sender());
 
-    if (action == actionCollection()->action(QStringLiteral("toggle-session-prevent-closing"))) {
+    if (action == actionCollection()->action(QStringLiteral("toggle-session-prevent-closing")))
         m_sessionStack->setSessionClosable(sessionId, !checked);
 
-        // Repaint the tab bar when the Prevent Closing action is toggled
-        // so the lock icon is added to or removed from the tab label.
-        m_tabBar->repaint();
-    }
-
     if (action == actionCollection()->action(QStringLiteral("toggle-session-keyboard-input")))
         m_sessionStack->setSessionKeyboardInputEnabled(sessionId, !checked);
 
@@ -921,8 +1076,6 @@ void MainWindow::applySettings()
         disconnect(m_sessionStack, SIGNAL(titleChanged(int, QString)), m_tabBar, SLOT(setTabTitleAutomated(int, QString)));
     }
 
-    m_animationTimer.setInterval(Settings::frames() ? 10 : 0);
-
     m_tabBar->setVisible(Settings::showTabBar());
     m_titleBar->setVisible(Settings::showTitleBar());
 
@@ -961,6 +1114,9 @@ void MainWindow::applySettings()
     applySkin();
     applyWindowGeometry();
     applyWindowProperties();
+
+    // Session restore may just have been turned on.
+    m_sessionStore->scheduleSave();
 }
 
 void MainWindow::applySkin()
@@ -1047,10 +1203,7 @@ void MainWindow::setWindowGeometry(int newWidth, int newHeight, int newPosition)
     if (!isVisible())
         m_titleBar->updateMask();
 
-    if (Settings::frames() > 0)
-        m_animationStepSize = maxHeight / Settings::frames();
-    else
-        m_animationStepSize = maxHeight;
+    m_animationHeight = maxHeight;
 
     auto borderWidth = Settings::hideSkinBorders() ? 0 : m_skin->borderWidth();
 
@@ -1066,6 +1219,8 @@ void MainWindow::setWindowGeometry(int newWidth, int newHeight, int newPosition)
     m_sessionStack->setGeometry(borderWidth, 0, width() - 2 * borderWidth, maxHeight - borderWidth);
 
     updateMask();
+
+    updateEdgeTrigger();
 }
 
 void MainWindow::setScreen(QAction *action)
@@ -1233,29 +1388,280 @@ bool MainWindow::focusNextPrevChild(bool)
     return false;
 }
 
-void MainWindow::toggleWindowState()
+QVariantMap MainWindow::state()
 {
-    if (m_isWayland) {
-        auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.plasmashell"),
-                                                      QStringLiteral("/StrutManager"),
-                                                      QStringLiteral("org.kde.PlasmaShell.StrutManager"),
-                                                      QStringLiteral("availableScreenRect"));
-        const QString screenName = m_outputOrderWatcher->outputOrder().at(getScreen());
-        message.setArguments({screenName});
-        QDBusPendingCall call = QDBusConnection::sessionBus().asyncCall(message);
-        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    QVariantList sessions;
 
-        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, this, [=, this]() {
-            QDBusPendingReply<QRect> reply = *watcher;
-            m_availableScreenRect = reply.isValid() ? reply.value() : QRect();
-            setWindowGeometry(Settings::width(), Settings::height(), Settings::position());
-            watcher->deleteLater();
-        });
+    for (int index = 0;; ++index) {
+        const int sessionId = m_tabBar->sessionAtTab(index);
 
-        _toggleWindowState();
+        if (sessionId == -1)
+            break;
+
+        QVariantMap session = m_sessionStack->sessionState(sessionId);
+
+        if (session.isEmpty())
+            continue;
+
+        session[QStringLiteral("title")] = m_tabBar->tabTitle(sessionId);
+        session[QStringLiteral("titleSetInteractively")] = m_tabBar->isTabTitleSetInteractively(sessionId);
+        session[QStringLiteral("keyboardInputEnabled")] = m_sessionStack->isSessionKeyboardInputEnabled(sessionId);
+        session[QStringLiteral("monitorActivityEnabled")] = m_sessionStack->isSessionMonitorActivityEnabled(sessionId);
+        session[QStringLiteral("monitorSilenceEnabled")] = m_sessionStack->isSessionMonitorSilenceEnabled(sessionId);
+
+        sessions << session;
+    }
+
+    QVariantMap state;
+    state[QStringLiteral("version")] = 1;
+    state[QStringLiteral("visible")] = isVisible();
+    state[QStringLiteral("activeSessionId")] = m_sessionStack->activeSessionId();
+    state[QStringLiteral("activeTerminalId")] = m_sessionStack->activeTerminalId();
+    state[QStringLiteral("sessions")] = sessions;
+
+    return state;
+}
+
+QList<int> MainWindow::executeBatch(const QVariantList &operations)
+{
+    QList<int> results;
+    results.reserve(operations.count());
+
+    // Only paint the final state instead of every step towards it.
+    const bool updatesWereEnabled = updatesEnabled();
+    setUpdatesEnabled(false);
+
+    for (int i = 0; i < operations.count(); ++i) {
+        bool ok = false;
+
+        // Maps nested in a variant list arrive still marshalled over D-Bus.
+        const int result = executeBatchOperation(qdbus_cast<QVariantMap>(operations.at(i)), results, ok);
+
+        // Whatever comes after a broken operation may well depend on it.
+        if (!ok) {
+            if (calledFromDBus())
+                sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("Operation %1 of the batch is invalid.").arg(i));
+
+            break;
+        }
+
+        results << result;
+    }
+
+    setUpdatesEnabled(updatesWereEnabled);
+
+    return results;
+}
+
+static bool batchId(const QVariant &value, const QList<int> &results, int &id)
+{
+    const QString reference = value.toString();
+    bool ok = false;
+
+    if (reference.startsWith(QLatin1Char('$'))) {
+        const int index = QStringView(reference).mid(1).toInt(&ok);
+
+        if (!ok || index < 0 || index >= results.count())
+            return false;
+
+        id = results.at(index);
     } else {
-        _toggleWindowState();
+        id = value.toInt(&ok);
+
+        if (!ok)
+            return false;
+    }
+
+    // The methods take -1 for the active session or terminal, which is
+    // only meant to happen when no id is given at all.
+    return id >= 0;
+}
+
+int MainWindow::executeBatchOperation(const QVariantMap &operation, const QList<int> &results, bool &ok)
+{
+    ok = false;
+
+    const QString op = operation.value(QStringLiteral("op")).toString();
+
+    int sessionId = -1;
+
+    if (operation.contains(QStringLiteral("sessionId"))) {
+        if (!batchId(operation.value(QStringLiteral("sessionId")), results, sessionId))
+            return -1;
+
+        if (!m_sessionStack->sessionIds().contains(sessionId))
+            return -1;
+    }
+
+    int terminalId = -1;
+
+    if (operation.contains(QStringLiteral("terminalId"))) {
+        if (!batchId(operation.value(QStringLiteral("terminalId")), results, terminalId))
+            return -1;
+
+        if (m_sessionStack->sessionIdForTerminalId(terminalId) == -1)
+            return -1;
+    } else if (operation.contains(QStringLiteral("sessionId"))) {
+        terminalId = m_sessionStack->activeTerminalIdForSession(sessionId);
+
+        if (terminalId == -1)
+            return -1;
+    } else {
+        terminalId = m_sessionStack->activeTerminalId();
+    }
+
+    ok = true;
+
+    const bool enabled = operation.value(QStringLiteral("enabled"), true).toBool();
+    const uint pixels = operation.value(QStringLiteral("pixels"), 10).toUInt();
+
+    // Operations that create a session or terminal fail with -1.
+    const auto created = [&ok](int id) {
+        ok = (id != -1);
+        return id;
+    };
+
+    if (op == QLatin1String("addSession"))
+        return created(m_sessionStack->addSession());
+    if (op == QLatin1String("addSessionTwoHorizontal"))
+        return created(m_sessionStack->addSessionTwoHorizontal());
+    if (op == QLatin1String("addSessionTwoVertical"))
+        return created(m_sessionStack->addSessionTwoVertical());
+    if (op == QLatin1String("addSessionQuad"))
+        return created(m_sessionStack->addSessionQuad());
+    if (op == QLatin1String("addSessionWithLayout"))
+        return created(addSessionWithLayout(operation.value(QStringLiteral("layout")).toString()));
+    if (op == QLatin1String("splitSessionAuto"))
+        return created(m_sessionStack->splitSessionAuto(sessionId));
+    if (op == QLatin1String("splitSessionLeftRight"))
+        return created(m_sessionStack->splitSessionLeftRight(sessionId));
+    if (op == QLatin1String("splitSessionTopBottom"))
+        return created(m_sessionStack->splitSessionTopBottom(sessionId));
+    if (op == QLatin1String("splitTerminalLeftRight"))
+        return created(m_sessionStack->splitTerminalLeftRight(terminalId));
+    if (op == QLatin1String("splitTerminalTopBottom"))
+        return created(m_sessionStack->splitTerminalTopBottom(terminalId));
+    if (op == QLatin1String("tryGrowTerminalRight"))
+        return m_sessionStack->tryGrowTerminalRight(terminalId, pixels);
+    if (op == QLatin1String("tryGrowTerminalLeft"))
+        return m_sessionStack->tryGrowTerminalLeft(terminalId, pixels);
+    if (op == QLatin1String("tryGrowTerminalTop"))
+        return m_sessionStack->tryGrowTerminalTop(terminalId, pixels);
+    if (op == QLatin1String("tryGrowTerminalBottom"))
+        return m_sessionStack->tryGrowTerminalBottom(terminalId, pixels);
+    if (op == QLatin1String("focusTerminalLeft"))
+        return m_sessionStack->focusTerminalLeft(terminalId);
+    if (op == QLatin1String("focusTerminalRight"))
+        return m_sessionStack->focusTerminalRight(terminalId);
+    if (op == QLatin1String("focusTerminalUp"))
+        return m_sessionStack->focusTerminalUp(terminalId);
+    if (op == QLatin1String("focusTerminalDown"))
+        return m_sessionStack->focusTerminalDown(terminalId);
+    if (op == QLatin1String("toggleTerminalZoom"))
+        return m_sessionStack->toggleTerminalZoom(terminalId) ? 1 : 0;
+
+    if (op == QLatin1String("raiseSession"))
+        m_sessionStack->raiseSession(sessionId);
+    else if (op == QLatin1String("removeSession"))
+        m_sessionStack->removeSession(sessionId);
+    else if (op == QLatin1String("removeTerminal"))
+        m_sessionStack->removeTerminal(terminalId);
+    else if (op == QLatin1String("rebalanceSession"))
+        m_sessionStack->rebalanceSession(sessionId,
+                                         operation.value(QStringLiteral("mode")).toString(),
+                                         qdbus_cast<QVariantMap>(operation.value(QStringLiteral("weights"))));
+#if !defined(REMOVE_SENDTEXT_RUNCOMMAND_DBUS_METHODS)
+    else if (op == QLatin1String("runCommandInTerminal"))
+        m_sessionStack->runCommandInTerminal(terminalId, operation.value(QStringLiteral("command")).toString());
+#endif
+    else if (op == QLatin1String("setTabTitle"))
+        m_tabBar->setTabTitle(sessionId, operation.value(QStringLiteral("title")).toString());
+    else if (op == QLatin1String("setSessionClosable"))
+        m_sessionStack->setSessionClosable(sessionId, operation.value(QStringLiteral("closable"), true).toBool());
+    else if (op == QLatin1String("setSessionKeyboardInputEnabled"))
+        m_sessionStack->setSessionKeyboardInputEnabled(sessionId, enabled);
+    else if (op == QLatin1String("setTerminalKeyboardInputEnabled"))
+        m_sessionStack->setTerminalKeyboardInputEnabled(terminalId, enabled);
+    else if (op == QLatin1String("setSessionMonitorActivityEnabled"))
+        m_sessionStack->setSessionMonitorActivityEnabled(sessionId, enabled);
+    else if (op == QLatin1String("setTerminalMonitorActivityEnabled"))
+        m_sessionStack->setTerminalMonitorActivityEnabled(terminalId, enabled);
+    else if (op == QLatin1String("setSessionMonitorSilenceEnabled"))
+        m_sessionStack->setSessionMonitorSilenceEnabled(sessionId, enabled);
+    else if (op == QLatin1String("setTerminalMonitorSilenceEnabled"))
+        m_sessionStack->setTerminalMonitorSilenceEnabled(terminalId, enabled);
+    else
+        ok = false;
+
+    return -1;
+}
+
+int MainWindow::addSessionWithLayout(const QString &layout)
+{
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(layout.toUtf8(), &error);
+
+    if (error.error != QJsonParseError::NoError || !document.isObject())
+        return -1;
+
+    return addSessionFromDescription(document.object().toVariantMap());
+}
+
+int MainWindow::addSessionFromDescription(const QVariantMap &description, bool deferTerminals)
+{
+    const QVariantMap layout = description.value(QStringLiteral("layout")).toMap();
+    const int sessionId = m_sessionStack->addSessionWithLayout(layout, deferTerminals);
+
+    if (sessionId == -1)
+        return -1;
+
+    const QString title = description.value(QStringLiteral("title")).toString();
+
+    if (!title.isEmpty()) {
+        const bool interactive = description.value(QStringLiteral("titleSetInteractively"), true).toBool();
+        m_tabBar->setTabTitle(sessionId, title, interactive ? TabBar::Interactive : TabBar::NonInteractive);
+    }
+
+    if (description.contains(QStringLiteral("closable")))
+        m_sessionStack->setSessionClosable(sessionId, description.value(QStringLiteral("closable")).toBool());
+
+    return sessionId;
+}
+
+bool MainWindow::restoreSessions()
+{
+    if (!Settings::restoreSessions())
+        return false;
+
+    const QVariantMap state = m_sessionStore->load();
+    const QVariantList sessions = state.value(QStringLiteral("sessions")).toList();
+
+    const int savedActiveSessionId = state.value(QStringLiteral("activeSessionId"), -1).toInt();
+    int activeSessionId = -1;
+
+    for (const QVariant &session : sessions) {
+        const QVariantMap description = session.toMap();
+
+        // Terminals are only loaded once their session is first shown, so
+        // restoring many sessions costs about as much as restoring one.
+        const int sessionId = addSessionFromDescription(description, true);
+
+        if (description.value(QStringLiteral("sessionId"), -1).toInt() == savedActiveSessionId)
+            activeSessionId = sessionId;
     }
+
+    if (activeSessionId != -1)
+        m_sessionStack->raiseSession(activeSessionId);
+
+    return !sessions.isEmpty();
+}
+
+void MainWindow::toggleWindowState()
+{
+    if (!isVisible())
+        validateActiveScreen(QCursor::pos());
+
+    _toggleWindowState();
 }
 
 void MainWindow::_toggleWindowState()
@@ -1345,21 +1751,12 @@ void MainWindow::slideWindow()
 #if HAVE_X11
 void MainWindow::kwinAssistToggleWindowState(bool visible)
 {
-    bool gotEffect = false;
-
-    Display *display = QX11Info::display();
-    Atom atom = XInternAtom(display, "_KDE_SLIDE", false);
-    int count;
-    Atom *list = XListProperties(display, DefaultRootWindow(display), &count);
-
-    if (list != nullptr) {
-        gotEffect = (std::find(list, list + count, atom) != list + count);
-
-        XFree(list);
-    }
+    auto x11OutputOrderWatcher = qobject_cast<X11OutputOrderWatcher *>(m_outputOrderWatcher);
+    bool gotEffect = x11OutputOrderWatcher && x11OutputOrderWatcher->hasRootProperty(m_kdeSlideAtom);
 
     if (gotEffect) {
-        Atom atom = XInternAtom(display, "_KDE_SLIDE", false);
+        Display *display = QX11Info::display();
+        Atom atom = m_kdeSlideAtom;
 
         if (Settings::frames() > 0) {
             QVarLengthArray<long, 1024> data(4);
@@ -1402,10 +1799,7 @@ void MainWindow::kwinAssistPropCleanup()
     if (!QX11Info::isPlatformX11())
         return;
 
-    Display *display = QX11Info::display();
-    Atom atom = XInternAtom(display, "_KDE_SLIDE", false);
-
-    XDeleteProperty(display, winId(), atom);
+    XDeleteProperty(QX11Info::display(), winId(), m_kdeSlideAtom);
 
     m_kwinAssistPropSet = false;
 }
@@ -1416,54 +1810,85 @@ void MainWindow::xshapeToggleWindowState(bool visible)
     if (m_animationTimer.isActive())
         return;
 
+    // Tick once per screen refresh; the slide position itself is derived
+    // from the elapsed time, so a busy event loop drops frames instead of
+    // slowing the animation down.
+    const qreal refreshRate = screen() ? screen()->refreshRate() : 0;
+    m_animationTimer.setTimerType(Qt::PreciseTimer);
+    m_animationTimer.setInterval(refreshRate > 0 ? qMax(1, qRound(1000 / refreshRate)) : 16);
+
     if (visible) {
         sharedPreHideWindow();
 
-        m_animationFrame = Settings::frames();
+        m_animationMask = m_titleBar->mask();
+        m_animationPosition = m_animationHeight;
 
         connect(&m_animationTimer, &QTimer::timeout, this, &MainWindow::xshapeRetractWindow);
-        m_animationTimer.start();
     } else {
-        m_animationFrame = 0;
+        sharedPreOpenWindow();
+
+        m_animationMask = m_titleBar->mask();
+        m_animationPosition = -1;
+
+        show();
+
+        sharedAfterOpenWindow();
 
         connect(&m_animationTimer, &QTimer::timeout, this, &MainWindow::xshapeOpenWindow);
-        m_animationTimer.start();
     }
+
+    m_animationClock.start();
+    m_animationTimer.start();
+
+    // Show the first frame right away rather than one interval later.
+    if (visible)
+        xshapeRetractWindow();
+    else
+        xshapeOpenWindow();
 }
 
-void MainWindow::xshapeOpenWindow()
+qreal MainWindow::xshapeAnimationProgress() const
 {
-    if (m_animationFrame == 0) {
-        sharedPreOpenWindow();
+    const int duration = Settings::frames() * 10;
 
-        show();
+    if (duration <= 0)
+        return 1.0;
 
-        sharedAfterOpenWindow();
-    }
+    return qMin(qreal(1.0), m_animationClock.elapsed() / qreal(duration));
+}
 
-    if (m_animationFrame == Settings::frames()) {
+void MainWindow::xshapeSetAnimationPosition(int position)
+{
+    // Only talk to the X server when the slide actually moved.
+    if (position == m_animationPosition)
+        return;
+
+    m_animationPosition = position;
+
+    m_titleBar->move(0, position);
+    setMask(m_animationMask.translated(0, position) + QRegion(0, 0, width(), position));
+}
+
+void MainWindow::xshapeOpenWindow()
+{
+    const qreal progress = xshapeAnimationProgress();
+
+    if (progress >= 1.0) {
         m_animationTimer.stop();
         m_animationTimer.disconnect();
 
         m_titleBar->move(0, height() - m_titleBar->height());
         updateMask();
     } else {
-        int maskHeight = m_animationStepSize * m_animationFrame;
-
-        QRegion newMask = m_titleBar->mask();
-        newMask.translate(0, maskHeight);
-        newMask += QRegion(0, 0, width(), maskHeight);
-
-        m_titleBar->move(0, maskHeight);
-        setMask(newMask);
-
-        m_animationFrame++;
+        xshapeSetAnimationPosition(qRound(m_animationHeight * progress));
     }
 }
 
 void MainWindow::xshapeRetractWindow()
 {
-    if (m_animationFrame == 0) {
+    const qreal progress = xshapeAnimationProgress();
+
+    if (progress >= 1.0) {
         m_animationTimer.stop();
         m_animationTimer.disconnect();
 
@@ -1471,10 +1896,7 @@ void MainWindow::xshapeRetractWindow()
 
         sharedAfterHideWindow();
     } else {
-        m_titleBar->move(0, m_titleBar->y() - m_animationStepSize);
-        setMask(QRegion(mask()).translated(0, -m_animationStepSize));
-
-        --m_animationFrame;
+        xshapeSetAnimationPosition(qRound(m_animationHeight * (1.0 - progress)));
     }
 }
 
@@ -1521,6 +1943,10 @@ void MainWindow::sharedAfterHideWindow()
     delete m_plasmaShellSurface;
     m_plasmaShellSurface = nullptr;
 
+    // Panels may have been added, moved or resized while the window was open.
+    if (m_isWayland)
+        refreshAvailableScreenRects();
+
     Q_EMIT windowClosed();
 }
 
@@ -1531,15 +1957,74 @@ void MainWindow::activate()
 
 void MainWindow::toggleMousePoll(bool poll)
 {
+    if (m_edgeTrigger) {
+        m_edgeTrigger->setEnabled(poll);
+
+        if (poll)
+            updateEdgeTrigger();
+
+        return;
+    }
+
     if (poll)
         m_mousePoller.start(Settings::pollInterval());
     else
         m_mousePoller.stop();
 }
 
+void MainWindow::updateEdgeTrigger()
+{
+    if (!m_edgeTrigger || !m_edgeTrigger->isEnabled())
+        return;
+
+    // Mirror pollMouse(): the trigger area is the top edge of the screen, as
+    // wide as the window would be. The window follows the active screen unless
+    // a fixed one is configured, so cover every screen it may open on.
+    const auto screenNames = m_outputOrderWatcher->outputOrder();
+    const bool fixedScreen = Settings::screen() > 0 && Settings::screen() <= screenNames.length();
+    QList<QRect> areas;
+
+    for (int i = 0; i < screenNames.size(); ++i) {
+        if (fixedScreen && i != Settings::screen() - 1)
+            continue;
+
+        QScreen *screen = findScreenByName(screenNames.at(i));
+
+        if (!screen)
+            continue;
+
+        const qreal devicePixelRatio = screen->devicePixelRatio();
+        QRect screenGeometry = screen->geometry();
+        screenGeometry.moveTo(screenGeometry.topLeft() / devicePixelRatio);
+
+        QRect workArea = screenGeometry;
+
+        if (m_workAreaCache)
+            workArea = m_workAreaCache->workArea(screenGeometry);
+#if HAVE_X11
+        else
+            workArea = KX11Extras::workArea().intersected(screenGeometry);
+#endif
+
+        const int windowX = workArea.x() + workArea.width() * Settings::position() * (100 - Settings::width()) / 10000;
+        const int windowWidth = workArea.width() * Settings::width() / 100;
+
+        // Along the top of the screen itself, which is only at 0 for those
+        // without another screen above them.
+        const int screenTop = qRound(screenGeometry.top() * devicePixelRatio);
+
+        areas << QRect(qRound(windowX * devicePixelRatio), screenTop, qRound(windowWidth * devicePixelRatio) + 1, 1);
+    }
+
+    m_edgeTrigger->setAreas(areas);
+}
+
 void MainWindow::pollMouse()
 {
     QPoint pos = QCursor::pos();
+
+    validateActiveScreen(pos);
+
     QRect workArea = getDesktopGeometry();
 
     int windowX = workArea.x() + workArea.width() * Settings::position() * (100 - Settings::width()) / 10000;
@@ -1565,29 +2050,113 @@ void MainWindow::setKeepOpen(bool keepOpen)
 int MainWindow::getScreen()
 {
     if (Settings::screen() <= 0 || Settings::screen() > m_outputOrderWatcher->outputOrder().length()) {
-        auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.KWin"),
-                                                      QStringLiteral("/KWin"),
-                                                      QStringLiteral("org.kde.KWin"),
-                                                      QStringLiteral("activeOutputName"));
-        QDBusReply<QString> reply = QDBusConnection::sessionBus().call(message);
-
-        if (reply.isValid()) {
-            const auto screens = m_outputOrderWatcher->outputOrder();
-            for (int i = 0; i < screens.size(); ++i) {
-                if (screens[i] == reply.value())
-                    return i;
-            }
+        if (m_activeScreen == -1) {
+            QDBusReply<QString> reply = QDBusConnection::sessionBus().call(activeOutputNameMessage());
+            const QPoint cursorPos = QCursor::pos();
+
+            m_activeScreen = screenForOutputName(reply.isValid() ? reply.value() : QString(), cursorPos);
+            m_activeScreenCursorScreen = screenNameAt(cursorPos);
         }
-        // Right after unplugging an external monitor and the Yakuake window was on
-        // that monitor, QGuiApplication::screenAt() can return nullptr so we fallback on
-        // the first monitor.
-        QScreen *screen = QGuiApplication::screenAt(QCursor::pos());
-        return screen ? m_outputOrderWatcher->outputOrder().indexOf(screen->name()) : 0;
+
+        return m_activeScreen;
     } else {
         return Settings::screen() - 1;
     }
 }
 
+QString MainWindow::getScreenName()
+{
+    const int screen = getScreen();
+    const auto screens = m_outputOrderWatcher->outputOrder();
+
+    return (screen >= 0 && screen < screens.size()) ? screens.at(screen) : QString();
+}
+
+QDBusMessage MainWindow::activeOutputNameMessage()
+{
+    return QDBusMessage::createMethodCall(QStringLiteral("org.kde.KWin"),
+                                          QStringLiteral("/KWin"),
+                                          QStringLiteral("org.kde.KWin"),
+                                          QStringLiteral("activeOutputName"));
+}
+
+int MainWindow::screenForOutputName(const QString &outputName, const QPoint &cursorPos)
+{
+    const auto screens = m_outputOrderWatcher->outputOrder();
+
+    if (!outputName.isEmpty()) {
+        for (int i = 0; i < screens.size(); ++i) {
+            if (screens[i] == outputName)
+                return i;
+        }
+    }
+
+    // Right after unplugging an external monitor and the Yakuake window was on
+    // that monitor, QGuiApplication::screenAt() can return nullptr so we fallback on
+    // the first monitor.
+    QScreen *screen = QGuiApplication::screenAt(cursorPos);
+    return screen ? screens.indexOf(screen->name()) : 0;
+}
+
+QString MainWindow::screenNameAt(const QPoint &pos)
+{
+    QScreen *screen = QGuiApplication::screenAt(pos);
+    return screen ? screen->name() : QString();
+}
+
+void MainWindow::validateActiveScreen(const QPoint &cursorPos)
+{
+    if (m_activeScreen == -1)
+        return;
+
+    // On X11 the cached value stays good as long as the pointer is on the
+    // same screen as when it was resolved. Wayland clients don't learn about
+    // the pointer position while hidden, so ask KWin once per toggle there.
+    if (!m_isX11 || screenNameAt(cursorPos) != m_activeScreenCursorScreen)
+        invalidateActiveScreen();
+}
+
+void MainWindow::invalidateActiveScreen()
+{
+    m_activeScreen = -1;
+    ++m_activeScreenGeneration;
+}
+
+void MainWindow::scheduleActiveScreenRefresh()
+{
+    invalidateActiveScreen();
+
+    if (m_isX11 && !isVisible())
+        m_activeScreenRefreshTimer.start();
+}
+
+void MainWindow::refreshActiveScreen()
+{
+    if (m_activeScreen != -1)
+        return;
+    if (Settings::screen() > 0 && Settings::screen() <= m_outputOrderWatcher->outputOrder().length())
+        return;
+
+    const uint generation = m_activeScreenGeneration;
+
+    QDBusPendingCall call = QDBusConnection::sessionBus().asyncCall(activeOutputNameMessage());
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, generation]() {
+        QDBusPendingReply<QString> reply = *watcher;
+
+        // Drop the reply if the cache got invalidated or resolved meanwhile.
+        if (generation == m_activeScreenGeneration && m_activeScreen == -1 && reply.isValid()) {
+            const QPoint cursorPos = QCursor::pos();
+
+            m_activeScreen = screenForOutputName(reply.value(), cursorPos);
+            m_activeScreenCursorScreen = screenNameAt(cursorPos);
+        }
+
+        watcher->deleteLater();
+    });
+}
+
 QRect MainWindow::getScreenGeometry()
 {
     if (getScreen() == -1 || m_outputOrderWatcher->outputOrder().size() <= getScreen()) {
@@ -1606,6 +2175,42 @@ QRect MainWindow::getScreenGeometry()
     return screenGeometry;
 }
 
+void MainWindow::refreshAvailableScreenRects()
+{
+    const auto screens = m_outputOrderWatcher->outputOrder();
+
+    for (auto it = m_availableScreenRects.begin(); it != m_availableScreenRects.end();) {
+        if (screens.contains(it.key()))
+            ++it;
+        else
+            it = m_availableScreenRects.erase(it);
+    }
+
+    for (const QString &screenName : screens) {
+        auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.plasmashell"),
+                                                      QStringLiteral("/StrutManager"),
+                                                      QStringLiteral("org.kde.PlasmaShell.StrutManager"),
+                                                      QStringLiteral("availableScreenRect"));
+        message.setArguments({screenName});
+        QDBusPendingCall call = QDBusConnection::sessionBus().asyncCall(message);
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, this, [=, this]() {
+            QDBusPendingReply<QRect> reply = *watcher;
+            const QRect availableScreenRect = reply.isValid() ? reply.value() : QRect();
+            watcher->deleteLater();
+
+            if (m_availableScreenRects.value(screenName) == availableScreenRect)
+                return;
+
+            m_availableScreenRects.insert(screenName, availableScreenRect);
+
+            if (isVisible() && !m_animationTimer.isActive() && getScreenName() == screenName)
+                applyWindowGeometry();
+        });
+    }
+}
+
 QRect MainWindow::getDesktopGeometry()
 {
     QRect screenGeometry = getScreenGeometry();
@@ -1618,59 +2223,12 @@ QRect MainWindow::getDesktopGeometry()
     if (m_isWayland) {
         // on Wayland it's not possible to get the work area from KWindowSystem
         // but plasmashell provides this through dbus
-        return m_availableScreenRect.isValid() ? m_availableScreenRect : screenGeometry;
+        const QRect availableScreenRect = m_availableScreenRects.value(getScreenName());
+        return availableScreenRect.isValid() ? availableScreenRect : screenGeometry;
     }
 
-    if (m_outputOrderWatcher->outputOrder().count() > 1) {
-        const QList<WId> allWindows = KX11Extras::windows();
-        QList<WId> offScreenWindows;
-
-        QListIterator<WId> i(allWindows);
-
-        while (i.hasNext()) {
-            WId windowId = i.next();
-
-            if (KX11Extras::hasWId(windowId)) {
-                KWindowInfo windowInfo = KWindowInfo(windowId, NET::WMDesktop | NET::WMGeometry, NET::WM2ExtendedStrut);
-
-                // If windowInfo is valid and the window is located at the same (current)
-                // desktop with the yakuake window...
-                if (windowInfo.valid() && windowInfo.isOnCurrentDesktop()) {
-                    NETExtendedStrut strut = windowInfo.extendedStrut();
-
-                    // Get the area covered by each strut.
-                    QRect topStrut(strut.top_start, 0, strut.top_end - strut.top_start, strut.top_width);
-                    QRect bottomStrut(strut.bottom_start,
-                                      screenGeometry.bottom() - strut.bottom_width,
-                                      strut.bottom_end - strut.bottom_start,
-                                      strut.bottom_width);
-                    QRect leftStrut(0, strut.left_start, strut.left_width, strut.left_end - strut.left_start);
-                    QRect rightStrut(screenGeometry.right() - strut.right_width, strut.right_start, strut.right_width, strut.right_end - strut.right_start);
-
-                    // If the window has no strut, no need to bother further.
-                    if (topStrut.isEmpty() && bottomStrut.isEmpty() && leftStrut.isEmpty() && rightStrut.isEmpty())
-                        continue;
-
-                    // If any of the strut and the window itself intersects with our screen geometry,
-                    // it will be correctly handled by workArea(). If the window doesn't intersect
-                    // with our screen geometry it's most likely a plasma panel and can/should be
-                    // ignored
-                    if ((topStrut.intersects(screenGeometry) || bottomStrut.intersects(screenGeometry) || leftStrut.intersects(screenGeometry)
-                         || rightStrut.intersects(screenGeometry))
-                        && windowInfo.geometry().intersects(screenGeometry)) {
-                        continue;
-                    }
-
-                    // This window has a strut on the same desktop as us but which does not cover our screen
-                    // geometry. It should be ignored, otherwise the returned work area will wrongly include
-                    // the strut.
-                    offScreenWindows << windowId;
-                }
-            }
-        }
-
-        return KX11Extras::workArea(offScreenWindows).intersected(screenGeometry);
-    }
+    if (m_outputOrderWatcher->outputOrder().count() > 1 && m_workAreaCache)
+        return m_workAreaCache->workArea(screenGeometry);
 
 #if HAVE_X11
     return KX11Extras::workArea();
@@ -12,16 +12,25 @@
 
 #include <KMainWindow>
 
+#include <QDBusContext>
+#include <QDBusMessage>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRegion>
 #include <QTimer>
+#include <QVariantMap>
 
 #include "outputorderwatcher.h"
 
+class EdgeTrigger;
 class FirstRunDialog;
 class SessionStack;
+class SessionStore;
 class Skin;
 class TabBar;
 class Terminal;
 class TitleBar;
+class WorkAreaCache;
 
 class KHelpMenu;
 class KActionCollection;
@@ -36,7 +45,7 @@ class PlasmaShellSurface;
 }
 }
 
-class MainWindow : public KMainWindow
+class MainWindow : public KMainWindow, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.yakuake")
@@ -75,6 +84,44 @@ public:
 public Q_SLOTS:
     Q_SCRIPTABLE void toggleWindowState();
 
+    /**
+     * Returns the whole session and terminal tree in one reply: the
+     * sessions in tab order with their tab titles and flags, the active
+     * ids, and each session's split layout.
+     */
+    Q_SCRIPTABLE QVariantMap state();
+
+    /**
+     * Applies a list of operations in one go, without painting until the
+     * last one is done. Each operation is a map naming one of the session
+     * stack or tab bar D-Bus methods in "op", with its arguments under
+     * "sessionId", "terminalId", "command", "title", "closable", "enabled",
+     * "pixels", "mode", "weights" and "layout" (see addSessionWithLayout()).
+     * Ids can be given as "$n" to refer to the result of the n-th
+     * operation of the batch. A terminal operation without a "terminalId"
+     * applies to the active terminal of "sessionId", without either the
+     * active session and terminal are used.
+     *
+     * Returns one entry per operation holding what the named method
+     * returns, e.g. the id of a new session or terminal, or -1 for
+     * methods that return nothing. An unknown operation, an id that is
+     * not a valid number, refers to a failed or missing result or names no
+     * existing session or terminal, or a session or terminal that could
+     * not be created stops the batch with an InvalidArgs error; earlier
+     * operations stay applied.
+     */
+    Q_SCRIPTABLE QList<int> executeBatch(const QVariantList &operations);
+
+    /**
+     * Adds a session laid out as described by the JSON object @p layout,
+     * see Session::Session() for the format of the "layout" tree. A
+     * "title" sets the tab title, "closable" the Prevent Closing toggle;
+     * the output of state() for a session is a valid description.
+     *
+     * Returns the id of the new session, or -1 if @p layout isn't valid.
+     */
+    Q_SCRIPTABLE int addSessionWithLayout(const QString &layout);
+
     void handleContextDependentAction(QAction *action = nullptr, int sessionId = -1);
     void handleContextDependentToggleAction(bool checked, QAction *action = nullptr, int sessionId = -1);
     void handleToggleTerminalKeyboardInput(bool checked);
@@ -127,6 +174,7 @@ private Q_SLOTS:
 
     void toggleMousePoll(bool poll);
     void pollMouse();
+    void updateEdgeTrigger();
 
     void setKeepOpen(bool keepOpen);
 
@@ -148,6 +196,10 @@ private Q_SLOTS:
 private:
     void setupActions();
 
+    int executeBatchOperation(const QVariantMap &operation, const QList<int> &results, bool &ok);
+    int addSessionFromDescription(const QVariantMap &description, bool deferTerminals = false);
+    bool restoreSessions();
+
     void setupMenu();
 
     void updateWindowSizeMenus();
@@ -158,9 +210,12 @@ private:
     void kwinAssistToggleWindowState(bool visible);
     void kwinAssistPropCleanup();
     bool m_kwinAssistPropSet;
+    xcb_atom_t m_kdeSlideAtom = XCB_ATOM_NONE;
 #endif
 
     void xshapeToggleWindowState(bool visible);
+    qreal xshapeAnimationProgress() const;
+    void xshapeSetAnimationPosition(int position);
 
     void sharedPreOpenWindow();
     void sharedAfterOpenWindow();
@@ -170,12 +225,28 @@ private:
     void updateMask();
 
     int getScreen();
+    QString getScreenName();
+    QDBusMessage activeOutputNameMessage();
+    int screenForOutputName(const QString &outputName, const QPoint &cursorPos);
+    QString screenNameAt(const QPoint &pos);
+    void validateActiveScreen(const QPoint &cursorPos);
+    void invalidateActiveScreen();
+    void scheduleActiveScreenRefresh();
+    void refreshActiveScreen();
     QRect getScreenGeometry();
     QRect getDesktopGeometry();
     QScreen *findScreenByName(const QString &screenName);
 
-    // get a better value from plasmashell through dbus in wayland case
-    QRect m_availableScreenRect;
+    // KWin's active output, resolved at most once per toggle; -1 if unknown
+    int m_activeScreen = -1;
+    QString m_activeScreenCursorScreen;
+    uint m_activeScreenGeneration = 0;
+    QTimer m_activeScreenRefreshTimer;
+
+    // get a better value from plasmashell through dbus in wayland case,
+    // fetched ahead of time for every output
+    void refreshAvailableScreenRects();
+    QHash<QString, QRect> m_availableScreenRects;
     void _toggleWindowState();
 
     void slideWindow();
@@ -203,8 +274,11 @@ private:
 
     QTimer m_animationTimer;
     QTimer m_mousePoller;
-    int m_animationFrame;
-    int m_animationStepSize;
+    EdgeTrigger *m_edgeTrigger = nullptr;
+    QElapsedTimer m_animationClock;
+    QRegion m_animationMask;
+    int m_animationHeight = 0;
+    int m_animationPosition = -1;
 
     bool m_toggleLock;
 
@@ -217,6 +291,8 @@ private:
     KWayland::Client::PlasmaShellSurface *m_plasmaShellSurface = nullptr;
 
     OutputOrderWatcher *m_outputOrderWatcher = nullptr;
+    WorkAreaCache *m_workAreaCache = nullptr;
+    SessionStore *m_sessionStore = nullptr;
 };
 
 #endif
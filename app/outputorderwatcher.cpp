@@ -281,7 +281,14 @@ bool X11OutputOrderWatcher::nativeEventFilter(const QByteArray &eventType, void
 
     const auto responseType = XCB_EVENT_RESPONSE_TYPE(ev);
 
-    if (responseType == m_xrandrExtensionOffset + XCB_RANDR_NOTIFY) {
+    if (responseType == XCB_PROPERTY_NOTIFY) {
+        auto *propertyEvent = reinterpret_cast<xcb_property_notify_event_t *>(ev);
+        auto it = m_rootProperties.find(propertyEvent->atom);
+
+        if (it != m_rootProperties.end() && propertyEvent->window == DefaultRootWindow(m_x11Interface->display())) {
+            *it = (propertyEvent->state == XCB_PROPERTY_NEW_VALUE);
+        }
+    } else if (responseType == m_xrandrExtensionOffset + XCB_RANDR_NOTIFY) {
         auto *randrEvent = reinterpret_cast<xcb_randr_notify_event_t *>(ev);
         if (randrEvent->subCode == XCB_RANDR_NOTIFY_OUTPUT_PROPERTY) {
             xcb_randr_output_property_t property = randrEvent->u.op;
@@ -310,6 +317,33 @@ bool X11OutputOrderWatcher::nativeEventFilter(const QByteArray &eventType, void
     return false;
 }
 
+void X11OutputOrderWatcher::watchRootProperty(xcb_atom_t atom)
+{
+    if (!m_x11Interface || atom == XCB_ATOM_NONE || m_rootProperties.contains(atom)) {
+        return;
+    }
+
+    xcb_connection_t *connection = m_x11Interface->connection();
+    const xcb_window_t rootWindow = DefaultRootWindow(m_x11Interface->display());
+
+    // Qt already selects property changes on the root window, but don't rely on it
+    ScopedPointer<xcb_get_window_attributes_reply_t> attributes(
+        xcb_get_window_attributes_reply(connection, xcb_get_window_attributes(connection, rootWindow), nullptr));
+    if (attributes && !(attributes->your_event_mask & XCB_EVENT_MASK_PROPERTY_CHANGE)) {
+        const uint32_t eventMask = attributes->your_event_mask | XCB_EVENT_MASK_PROPERTY_CHANGE;
+        xcb_change_window_attributes(connection, rootWindow, XCB_CW_EVENT_MASK, &eventMask);
+    }
+
+    ScopedPointer<xcb_get_property_reply_t> property(
+        xcb_get_property_reply(connection, xcb_get_property(connection, false, rootWindow, atom, XCB_ATOM_ANY, 0, 0), nullptr));
+    m_rootProperties.insert(atom, property && property->type != XCB_ATOM_NONE);
+}
+
+bool X11OutputOrderWatcher::hasRootProperty(xcb_atom_t atom) const
+{
+    return m_rootProperties.value(atom, false);
+}
+
 void X11OutputOrderWatcher::roundtrip() const
 {
     const auto cookie = xcb_get_input_focus(m_x11Interface->connection());
@@ -8,6 +8,7 @@
 
 #include <QAbstractNativeEventFilter>
 #include <QGuiApplication>
+#include <QHash>
 #include <QObject>
 
 #include <config-yakuake.h>
@@ -86,6 +87,14 @@ public:
     X11OutputOrderWatcher(QObject *parent);
     void refresh() override;
 
+    /**
+     * Starts tracking whether @p atom is set on the root window. The
+     * state is kept up to date from property change events, so
+     * hasRootProperty() doesn't need a server roundtrip.
+     */
+    void watchRootProperty(xcb_atom_t atom);
+    bool hasRootProperty(xcb_atom_t atom) const;
+
 protected:
     bool nativeEventFilter(const QByteArray &eventType, void *message, qintptr *result) override;
 
@@ -97,6 +106,8 @@ private:
     // Xrandr
     int m_xrandrExtensionOffset;
     xcb_atom_t m_kdeScreenAtom = XCB_ATOM_NONE;
+    // Watched root window properties and whether they are currently set
+    QHash<xcb_atom_t, bool> m_rootProperties;
 };
 #endif
 
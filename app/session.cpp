@@ -6,16 +6,24 @@
 */
 
 #include "session.h"
+#include "settings.h"
 #include "terminal.h"
+#include "terminalpool.h"
+
+#include <config-yakuake.h>
+
+#include <QApplication>
 
 #include <algorithm>
 
 int Session::m_availableSessionId = 0;
 
-Session::Session(const QString &workingDir, SessionType type, QWidget *parent)
+Session::Session(const QString &workingDir, const QVariantMap &layout, TerminalPool *terminalPool, bool deferTerminals, QWidget *parent)
     : QObject(parent)
 {
     m_workingDir = workingDir;
+    m_terminalPool = terminalPool;
+    m_deferTerminals = deferTerminals;
     m_sessionId = m_availableSessionId;
     m_availableSessionId++;
 
@@ -23,10 +31,25 @@ Session::Session(const QString &workingDir, SessionType type, QWidget *parent)
 
     m_closable = true;
 
-    m_baseSplitter = new Splitter(Qt::Horizontal, parent);
+    m_titleTimer.setSingleShot(true);
+    connect(&m_titleTimer, &QTimer::timeout, this, &Session::emitTitle);
+
+    connect(this, &Session::layoutChanged, this, [this]() {
+        m_neighborsValid = false;
+    });
+
+    m_baseSplitter = addSplitter(m_layout.root(), parent);
     connect(m_baseSplitter, SIGNAL(destroyed()), this, SLOT(prepareShutdown()));
 
-    setupSession(type);
+    Terminal *activeTerminal = nullptr;
+    setupLayout(m_layout.root(), layout, activeTerminal);
+
+    QWidget *terminalWidget = activeTerminal->terminalWidget();
+
+    if (terminalWidget)
+        terminalWidget->setFocus();
+
+    setActiveTerminal(activeTerminal->id());
 }
 
 Session::~Session()
@@ -37,122 +60,263 @@ Session::~Session()
     Q_EMIT destroyed(m_sessionId);
 }
 
-void Session::setupSession(SessionType type)
+QVariantMap Session::layoutForType(SessionType type)
 {
+    const QVariantMap pane;
+
+    QVariantMap row;
+    row[QStringLiteral("orientation")] = QStringLiteral("horizontal");
+    row[QStringLiteral("children")] = QVariantList{pane, pane};
+
+    QVariantMap column;
+    column[QStringLiteral("orientation")] = QStringLiteral("vertical");
+    column[QStringLiteral("children")] = QVariantList{pane, pane};
+
     switch (type) {
-    case Single: {
-        Terminal *terminal = addTerminal(m_baseSplitter);
-        setActiveTerminal(terminal->id());
+    case TwoHorizontal:
+        return row;
 
-        break;
+    case TwoVertical:
+        return column;
+
+    case Quad:
+        column[QStringLiteral("children")] = QVariantList{row, row};
+
+        return column;
+
+    default:
+        return pane;
     }
+}
 
-    case TwoHorizontal: {
-        int splitterWidth = m_baseSplitter->width();
+static QList<int> layoutSizes(const QVariantMap &layout, int count)
+{
+    // Only the proportions matter, QSplitter shares out its actual extent
+    // by the relative weight of the sizes it is given.
+    const int scale = 10000;
 
-        Terminal *terminal = addTerminal(m_baseSplitter);
-        addTerminal(m_baseSplitter);
+    QVariantList weights = layout.value(QStringLiteral("ratios")).toList();
 
-        QList<int> newSplitterSizes;
-        newSplitterSizes << (splitterWidth / 2) << (splitterWidth / 2);
-        m_baseSplitter->setSizes(newSplitterSizes);
+    if (weights.isEmpty())
+        weights = layout.value(QStringLiteral("sizes")).toList();
 
-        QWidget *terminalWidget = terminal->terminalWidget();
+    qreal total = 0;
 
-        if (terminalWidget) {
-            terminalWidget->setFocus();
-            setActiveTerminal(terminal->id());
-        }
+    if (weights.count() == count) {
+        for (const QVariant &weight : std::as_const(weights)) {
+            if (weight.toDouble() <= 0) {
+                total = 0;
+                break;
+            }
 
-        break;
+            total += weight.toDouble();
+        }
     }
 
-    case TwoVertical: {
-        m_baseSplitter->setOrientation(Qt::Vertical);
+    QList<int> sizes;
 
-        int splitterHeight = m_baseSplitter->height();
+    for (int i = 0; i < count; ++i)
+        sizes << ((total > 0) ? qRound(weights.at(i).toDouble() / total * scale) : (scale / count));
 
-        Terminal *terminal = addTerminal(m_baseSplitter);
-        addTerminal(m_baseSplitter);
+    return sizes;
+}
 
-        QList<int> newSplitterSizes;
-        newSplitterSizes << (splitterHeight / 2) << (splitterHeight / 2);
-        m_baseSplitter->setSizes(newSplitterSizes);
+void Session::setupLayout(LayoutTree::Node *split, const QVariantMap &layout, Terminal *&activeTerminal)
+{
+    const QVariantList children = layout.value(QStringLiteral("children")).toList();
+
+    if (children.isEmpty()) {
+        Terminal *terminal = addLayoutTerminal(split, layout);
+
+        if (!activeTerminal || layout.value(QStringLiteral("active")).toBool())
+            activeTerminal = terminal;
+
+        return;
+    }
+
+    if (layout.value(QStringLiteral("orientation")).toString() == QLatin1String("vertical"))
+        split->orientation = Qt::Vertical;
+    else
+        split->orientation = Qt::Horizontal;
 
-        QWidget *terminalWidget = terminal->terminalWidget();
+    m_splitters.value(split)->setOrientation(split->orientation);
 
-        if (terminalWidget) {
-            terminalWidget->setFocus();
-            setActiveTerminal(terminal->id());
+    for (const QVariant &child : children) {
+        const QVariantMap node = child.toMap();
+
+        if (node.value(QStringLiteral("children")).toList().isEmpty()) {
+            setupLayout(split, node, activeTerminal);
+            continue;
         }
 
-        break;
+        LayoutTree::Node *childSplit = m_layout.addSplit(split, Qt::Horizontal);
+        addSplitter(childSplit, m_splitters.value(split));
+
+        setupLayout(childSplit, node, activeTerminal);
     }
 
-    case Quad: {
-        int splitterWidth = m_baseSplitter->width();
-        int splitterHeight = m_baseSplitter->height();
+    setSplitSizes(split, layoutSizes(layout, children.count()));
+}
 
-        m_baseSplitter->setOrientation(Qt::Vertical);
+Terminal *Session::addLayoutTerminal(LayoutTree::Node *split, const QVariantMap &pane)
+{
+    Terminal *terminal = addTerminal(split, pane.value(QStringLiteral("workingDirectory")).toString());
+    const int terminalId = terminal->id();
+
+    if (pane.contains(QStringLiteral("keyboardInputEnabled")))
+        setKeyboardInputEnabled(terminalId, pane.value(QStringLiteral("keyboardInputEnabled")).toBool());
+
+    if (pane.contains(QStringLiteral("monitorActivityEnabled")))
+        setMonitorActivityEnabled(terminalId, pane.value(QStringLiteral("monitorActivityEnabled")).toBool());
+
+    if (pane.contains(QStringLiteral("monitorSilenceEnabled")))
+        setMonitorSilenceEnabled(terminalId, pane.value(QStringLiteral("monitorSilenceEnabled")).toBool());
+
+#if !defined(REMOVE_SENDTEXT_RUNCOMMAND_DBUS_METHODS)
+    // Running commands is subject to the same build option as runCommand().
+    const QString command = pane.value(QStringLiteral("command")).toString();
+
+    if (!command.isEmpty()) {
+        // Don't load a deferred terminal just to type into it.
+        if (terminal->isDeferred()) {
+            connect(
+                terminal,
+                &Terminal::materialized,
+                terminal,
+                [terminal, command]() {
+                    terminal->runCommand(command);
+                },
+                Qt::SingleShotConnection);
+        } else {
+            terminal->runCommand(command);
+        }
+    }
+#endif
 
-        Splitter *upperSplitter = new Splitter(Qt::Horizontal, m_baseSplitter);
-        connect(upperSplitter, SIGNAL(destroyed()), this, SLOT(cleanup()));
+    return terminal;
+}
 
-        Splitter *lowerSplitter = new Splitter(Qt::Horizontal, m_baseSplitter);
-        connect(lowerSplitter, SIGNAL(destroyed()), this, SLOT(cleanup()));
+Splitter *Session::addSplitter(LayoutTree::Node *split, QWidget *parent)
+{
+    Splitter *splitter = new Splitter(split->orientation, parent);
 
-        Terminal *terminal = addTerminal(upperSplitter);
-        addTerminal(upperSplitter);
+    m_splitters.insert(split, splitter);
+    m_splitterNodes.insert(splitter, split);
 
-        addTerminal(lowerSplitter);
-        addTerminal(lowerSplitter);
+    connect(splitter, &QSplitter::splitterMoved, this, [this, splitter]() {
+        LayoutTree::Node *split = m_splitterNodes.value(splitter);
 
-        QList<int> newSplitterSizes;
-        newSplitterSizes << (splitterHeight / 2) << (splitterHeight / 2);
-        m_baseSplitter->setSizes(newSplitterSizes);
+        if (!split)
+            return;
 
-        newSplitterSizes.clear();
-        newSplitterSizes << (splitterWidth / 2) << (splitterWidth / 2);
-        upperSplitter->setSizes(newSplitterSizes);
-        lowerSplitter->setSizes(newSplitterSizes);
+        split->sizes = splitter->sizes();
 
-        QWidget *terminalWidget = terminal->terminalWidget();
+        Q_EMIT layoutChanged();
+    });
+
+    return splitter;
+}
+
+void Session::setSplitSizes(LayoutTree::Node *split, const QList<int> &sizes)
+{
+    split->sizes = sizes;
+    m_splitters.value(split)->setSizes(sizes);
+}
+
+QList<int> Session::splitSizes(LayoutTree::Node *split) const
+{
+    Splitter *splitter = m_splitters.value(split);
+
+    // Shown splitters share out their space anew on every resize.
+    if (m_zoomedTerminalId == -1 && splitter && splitter->isVisible() && splitter->count() == int(split->children.size()))
+        return splitter->sizes();
+
+    return split->sizes;
+}
+
+void Session::updateSplitSizes(LayoutTree::Node *split)
+{
+    split->sizes = splitSizes(split);
+}
+
+void Session::updateSplitter(LayoutTree::Node *split)
+{
+    Splitter *splitter = m_splitters.value(split);
 
-        if (terminalWidget) {
-            terminalWidget->setFocus();
-            setActiveTerminal(terminal->id());
+    if (!splitter)
+        return;
+
+    splitter->setOrientation(split->orientation);
+
+    for (size_t i = 0; i < split->children.size(); ++i) {
+        const LayoutTree::Node *child = split->children[i].get();
+        QWidget *widget = nullptr;
+
+        if (child->isTerminal()) {
+            Terminal *terminal = getTerminal(child->terminalId);
+
+            if (!terminal)
+                continue;
+
+            terminal->setSplitter(splitter);
+            widget = terminal->partWidget();
+        } else {
+            widget = m_splitters.value(child);
         }
 
-        break;
+        // Moves widgets that are in the splitter already.
+        if (widget)
+            splitter->insertWidget(int(i), widget);
     }
 
-    default: {
-        addTerminal(m_baseSplitter);
+    if (!split->sizes.isEmpty())
+        splitter->setSizes(split->sizes);
+}
+
+void Session::applySplitSizes(LayoutTree::Node *split)
+{
+    Splitter *splitter = m_splitters.value(split);
 
-        break;
-    }
+    if (splitter && !split->sizes.isEmpty())
+        splitter->setSizes(split->sizes);
+
+    for (const std::unique_ptr<LayoutTree::Node> &child : split->children) {
+        if (!child->isTerminal())
+            applySplitSizes(child.get());
     }
 }
 
-Terminal *Session::addTerminal(QSplitter *parent, QString workingDir)
+Terminal *Session::addTerminal(LayoutTree::Node *split, QString workingDir)
 {
     if (workingDir.isEmpty()) {
         // fallback to session's default working dir
         workingDir = m_workingDir;
     }
 
-    std::unique_ptr<Terminal> terminal = std::make_unique<Terminal>(workingDir, parent);
+    Splitter *parent = m_splitters.value(split);
+
+    std::unique_ptr<Terminal> terminal = (m_terminalPool && !m_deferTerminals) ? m_terminalPool->take(workingDir) : nullptr;
+
+    if (terminal)
+        terminal->setSplitter(parent);
+    else
+        terminal = std::make_unique<Terminal>(workingDir, parent, m_deferTerminals);
+
     connect(terminal.get(), SIGNAL(activated(int)), this, SLOT(setActiveTerminal(int)));
     connect(terminal.get(), SIGNAL(manuallyActivated(Terminal *)), this, SIGNAL(terminalManuallyActivated(Terminal *)));
     connect(terminal.get(), SIGNAL(titleChanged(int, QString)), this, SLOT(setTitle(int, QString)));
     connect(terminal.get(), SIGNAL(keyboardInputBlocked(Terminal *)), this, SIGNAL(keyboardInputBlocked(Terminal *)));
     connect(terminal.get(), SIGNAL(silenceDetected(Terminal *)), this, SIGNAL(silenceDetected(Terminal *)));
     connect(terminal.get(), &Terminal::closeRequested, this, QOverload<int>::of(&Session::cleanup));
+    connect(terminal.get(), &Terminal::materialized, this, &Session::wantsBlurChanged);
 
     Terminal *term = terminal.get();
 
     m_terminals[terminal->id()] = std::move(terminal);
+    m_layout.addTerminal(split, term->id());
 
+    Q_EMIT terminalAdded(term->id());
+    Q_EMIT layoutChanged();
     Q_EMIT wantsBlurChanged();
 
     parent->addWidget(term->partWidget());
@@ -172,6 +336,19 @@ void Session::closeTerminal(int terminalId)
     if (!m_terminals.contains(terminalId))
         return;
 
+    // Terminals idling at their prompt go back to the pool rather than
+    // having their part torn down. They leave m_terminals before the pool
+    // reparents their widgets, cleanup() then only tidies up the layout.
+    if (m_terminalPool && m_terminalPool->canRecycle(m_terminals[terminalId].get())) {
+        if (m_activeTerminalId == terminalId && m_terminals.size() > 1)
+            focusPreviousTerminal();
+
+        std::unique_ptr<Terminal> terminal = std::move(m_terminals.extract(terminalId).mapped());
+        disconnect(terminal.get(), nullptr, this, nullptr);
+
+        m_terminalPool->recycle(std::move(terminal));
+    }
+
     cleanup(terminalId);
 }
 
@@ -182,6 +359,8 @@ void Session::focusPreviousTerminal()
     if (!m_terminals.contains(m_activeTerminalId))
         return;
 
+    unzoom();
+
     std::map<int, std::unique_ptr<Terminal>>::iterator currentTerminal = m_terminals.find(m_activeTerminalId);
 
     std::map<int, std::unique_ptr<Terminal>>::iterator previousTerminal;
@@ -205,6 +384,8 @@ void Session::focusNextTerminal()
     if (!m_terminals.contains(m_activeTerminalId))
         return;
 
+    unzoom();
+
     std::map<int, std::unique_ptr<Terminal>>::iterator currentTerminal = m_terminals.find(m_activeTerminalId);
 
     std::map<int, std::unique_ptr<Terminal>>::iterator nextTerminal = std::next(currentTerminal);
@@ -219,6 +400,157 @@ void Session::focusNextTerminal()
     }
 }
 
+int Session::focusTerminal(int terminalId, GrowthDirection direction)
+{
+    if (terminalId == -1)
+        terminalId = m_activeTerminalId;
+    if (terminalId == -1)
+        return -1;
+    if (!m_terminals.contains(terminalId))
+        return -1;
+
+    if (!m_neighborsValid) {
+        m_neighbors = m_layout.neighbors();
+        m_neighborsValid = true;
+    }
+
+    const LayoutTree::Neighbors neighbors = m_neighbors.value(terminalId);
+    int neighborId = -1;
+
+    switch (direction) {
+    case Up:
+        neighborId = neighbors.up;
+        break;
+    case Right:
+        neighborId = neighbors.right;
+        break;
+    case Down:
+        neighborId = neighbors.down;
+        break;
+    case Left:
+        neighborId = neighbors.left;
+        break;
+    }
+
+    if (!m_terminals.contains(neighborId))
+        return -1;
+
+    QWidget *terminalWidget = m_terminals[neighborId]->terminalWidget();
+
+    if (!terminalWidget)
+        return -1;
+
+    unzoom();
+
+    terminalWidget->setFocus();
+
+    return neighborId;
+}
+
+bool Session::toggleZoom(int terminalId)
+{
+    if (terminalId == -1)
+        terminalId = m_activeTerminalId;
+    if (terminalId == -1)
+        return false;
+    if (!m_terminals.contains(terminalId))
+        return false;
+
+    if (m_zoomedTerminalId == terminalId) {
+        unzoom();
+
+        return false;
+    }
+
+    unzoom();
+    zoom(terminalId);
+
+    return (m_zoomedTerminalId != -1);
+}
+
+void Session::rebalance(LayoutTree::Balance balance, const QHash<int, qreal> &weights)
+{
+    if (!m_baseSplitter)
+        return;
+
+    unzoom();
+
+    m_layout.rebalance(balance, m_activeTerminalId, weights);
+
+    // A visible splitter lays out its children as soon as it's resized, so
+    // applying the sizes level by level would reflow the nested terminals
+    // once per level. Hidden widgets only note their new geometry, and get
+    // a single resize event at their final size when shown again.
+    const bool visible = m_baseSplitter->isVisible();
+    QWidget *focusWidget = QApplication::focusWidget();
+
+    if (visible)
+        m_baseSplitter->hide();
+
+    applySplitSizes(m_layout.root());
+
+    if (visible) {
+        m_baseSplitter->show();
+
+        if (focusWidget && m_baseSplitter->isAncestorOf(focusWidget))
+            focusWidget->setFocus(Qt::OtherFocusReason);
+    }
+
+    Q_EMIT layoutChanged();
+}
+
+void Session::zoom(int terminalId)
+{
+    LayoutTree::Node *node = m_layout.terminalNode(terminalId);
+
+    if (!node || m_terminals.size() < 2)
+        return;
+
+    for (LayoutTree::Node *split = node->parent; split; split = split->parent)
+        updateSplitSizes(split);
+
+    m_zoomedTerminalId = terminalId;
+
+    // Hidden widgets keep their geometry, so the other terminals don't
+    // reflow now or when they are shown again at the same size.
+    for (LayoutTree::Node *child = node, *split = node->parent; split; child = split, split = split->parent) {
+        Splitter *splitter = m_splitters.value(split);
+        const int index = split->indexOf(child);
+
+        for (int i = 0; splitter && i < splitter->count(); ++i) {
+            if (i != index)
+                splitter->widget(i)->hide();
+        }
+    }
+
+    QWidget *terminalWidget = m_terminals[terminalId]->terminalWidget();
+
+    if (terminalWidget)
+        terminalWidget->setFocus();
+}
+
+void Session::unzoom()
+{
+    if (m_zoomedTerminalId == -1)
+        return;
+
+    LayoutTree::Node *node = m_layout.terminalNode(m_zoomedTerminalId);
+    m_zoomedTerminalId = -1;
+
+    for (LayoutTree::Node *split = node ? node->parent : nullptr; split; split = split->parent) {
+        Splitter *splitter = m_splitters.value(split);
+
+        if (!splitter)
+            continue;
+
+        for (int i = 0; i < splitter->count(); ++i)
+            splitter->widget(i)->show();
+
+        if (!split->sizes.isEmpty())
+            splitter->setSizes(split->sizes);
+    }
+}
+
 int Session::splitLeftRight(int terminalId)
 {
     if (terminalId == -1)
@@ -275,19 +607,25 @@ int Session::splitAuto(int terminalId)
 
 int Session::split(Terminal *terminal, Qt::Orientation orientation)
 {
-    Splitter *splitter = static_cast<Splitter *>(terminal->splitter());
+    unzoom();
 
-    if (splitter->count() == 1) {
+    LayoutTree::Node *node = m_layout.terminalNode(terminal->id());
+    LayoutTree::Node *split = node->parent;
+    Splitter *splitter = m_splitters.value(split);
+
+    if (split->children.size() == 1) {
         int splitterWidth = splitter->width();
 
-        if (splitter->orientation() != orientation)
+        if (split->orientation != orientation) {
+            split->orientation = orientation;
             splitter->setOrientation(orientation);
+        }
 
-        terminal = addTerminal(splitter, terminal->currentWorkingDirectory());
+        terminal = addTerminal(split, terminal->currentWorkingDirectory());
 
         QList<int> newSplitterSizes;
         newSplitterSizes << (splitterWidth / 2) << (splitterWidth / 2);
-        splitter->setSizes(newSplitterSizes);
+        setSplitSizes(split, newSplitterSizes);
 
         QWidget *partWidget = terminal->partWidget();
         if (partWidget)
@@ -296,25 +634,27 @@ int Session::split(Terminal *terminal, Qt::Orientation orientation)
         m_activeTerminalId = terminal->id();
     } else {
         QList<int> splitterSizes = splitter->sizes();
+        const int index = split->indexOf(node);
 
-        Splitter *newSplitter = new Splitter(orientation, splitter);
-        connect(newSplitter, SIGNAL(destroyed()), this, SLOT(cleanup()));
+        LayoutTree::Node *newSplit = m_layout.wrapInSplit(node, orientation);
+        Splitter *newSplitter = addSplitter(newSplit, splitter);
 
-        if (splitter->indexOf(terminal->partWidget()) == 0)
-            splitter->insertWidget(0, newSplitter);
+        splitter->insertWidget(index, newSplitter);
 
         QWidget *partWidget = terminal->partWidget();
         if (partWidget)
-            partWidget->setParent(newSplitter);
+            newSplitter->addWidget(partWidget);
 
         terminal->setSplitter(newSplitter);
 
-        terminal = addTerminal(newSplitter, terminal->currentWorkingDirectory());
+        const int size = splitterSizes.value(index);
+
+        terminal = addTerminal(newSplit, terminal->currentWorkingDirectory());
 
-        splitter->setSizes(splitterSizes);
+        setSplitSizes(split, splitterSizes);
         QList<int> newSplitterSizes;
-        newSplitterSizes << (splitterSizes[1] / 2) << (splitterSizes[1] / 2);
-        newSplitter->setSizes(newSplitterSizes);
+        newSplitterSizes << (size / 2) << (size / 2);
+        setSplitSizes(newSplit, newSplitterSizes);
 
         newSplitter->show();
 
@@ -330,20 +670,28 @@ int Session::split(Terminal *terminal, Qt::Orientation orientation)
 
 int Session::tryGrowTerminal(int terminalId, GrowthDirection direction, uint pixels)
 {
-    Terminal *terminal = getTerminal(terminalId);
-    Splitter *splitter = static_cast<Splitter *>(terminal->splitter());
-    QWidget *child = terminal->partWidget();
+    const LayoutTree::Node *child = m_layout.terminalNode(terminalId);
 
-    while (splitter) {
+    if (!child)
+        return -1;
+
+    unzoom();
+
+    LayoutTree::Node *split = child->parent;
+
+    while (split) {
         bool isHorizontal = (direction == Right || direction == Left);
         bool isForward = (direction == Down || direction == Right);
 
         // Detecting correct orientation.
-        if ((splitter->orientation() == Qt::Horizontal && isHorizontal) || (splitter->orientation() == Qt::Vertical && !isHorizontal)) {
-            int currentPos = splitter->indexOf(child);
+        if ((split->orientation == Qt::Horizontal && isHorizontal) || (split->orientation == Qt::Vertical && !isHorizontal)) {
+            int currentPos = split->indexOf(child);
+            int count = split->children.size();
 
             if (currentPos != -1 // Next/Prev movable element detection.
-                && (currentPos != 0 || isForward) && (currentPos != splitter->count() - 1 || !isForward)) {
+                && (currentPos != 0 || isForward) && (currentPos != count - 1 || !isForward)) {
+                Splitter *splitter = m_splitters.value(split);
+
                 QList<int> currentSizes = splitter->sizes();
                 int oldSize = currentSizes[currentPos];
 
@@ -351,13 +699,16 @@ int Session::tryGrowTerminal(int terminalId, GrowthDirection direction, uint pix
                 currentSizes[currentPos] += pixels;
                 currentSizes[affected] -= pixels;
                 splitter->setSizes(currentSizes);
+                split->sizes = splitter->sizes();
+
+                Q_EMIT layoutChanged();
 
-                return splitter->sizes().at(currentPos) - oldSize;
+                return split->sizes.at(currentPos) - oldSize;
             }
         }
         // Try with a higher level.
-        child = splitter;
-        splitter = static_cast<Splitter *>(splitter->parentWidget());
+        child = split;
+        split = split->parent;
     }
 
     return -1;
@@ -366,47 +717,129 @@ int Session::tryGrowTerminal(int terminalId, GrowthDirection direction, uint pix
 void Session::setActiveTerminal(int terminalId)
 {
     m_activeTerminalId = terminalId;
+    m_title = m_terminals[m_activeTerminalId]->title();
 
-    setTitle(m_activeTerminalId, m_terminals[m_activeTerminalId]->title());
+    // Switching terminals is user-initiated, don't hold the title back.
+    emitTitle();
 }
 
 void Session::setTitle(int terminalId, const QString &title)
 {
-    if (terminalId == m_activeTerminalId) {
-        m_title = title;
+    if (terminalId != m_activeTerminalId || title == m_title)
+        return;
 
-        Q_EMIT titleChanged(m_title);
-        Q_EMIT titleChanged(m_sessionId, m_title);
-    }
+    m_title = title;
+
+    // An update is already scheduled and will pick up the latest title.
+    if (m_titleTimer.isActive())
+        return;
+
+    const qint64 interval = Settings::titleUpdateInterval();
+    const qint64 elapsed = m_titleClock.isValid() ? m_titleClock.elapsed() : interval;
+
+    if (elapsed >= interval)
+        emitTitle();
+    else
+        m_titleTimer.start(interval - elapsed);
+}
+
+void Session::emitTitle()
+{
+    m_titleTimer.stop();
+    m_titleClock.start();
+
+    // The title may have changed back to what was shown last.
+    if (m_title == m_emittedTitle)
+        return;
+
+    m_emittedTitle = m_title;
+
+    Q_EMIT titleChanged(m_title);
+    Q_EMIT titleChanged(m_sessionId, m_title);
 }
 
 void Session::cleanup(int terminalId)
 {
+    unzoom();
+
     if (m_activeTerminalId == terminalId && m_terminals.size() > 1)
         focusPreviousTerminal();
 
+    if (LayoutTree::Node *node = m_layout.terminalNode(terminalId)) {
+        // Collapsing the layout moves space around between the splits
+        // the terminal was in, start out from what is on screen.
+        for (LayoutTree::Node *split = node->parent; split; split = split->parent)
+            updateSplitSizes(split);
+
+        std::vector<std::unique_ptr<LayoutTree::Node>> removedSplits;
+
+        if (LayoutTree::Node *split = m_layout.removeTerminal(terminalId, removedSplits))
+            updateSplitter(split);
+
+        for (const std::unique_ptr<LayoutTree::Node> &removedSplit : removedSplits) {
+            QPointer<Splitter> splitter = m_splitters.take(removedSplit.get());
+            m_splitterNodes.remove(splitter);
+
+            // Already gone if the whole session is being torn down.
+            if (splitter)
+                splitter->deleteLater();
+        }
+    }
+
+    // A no-op for terminals closeTerminal() handed to the pool.
     m_terminals.erase(terminalId);
+    Q_EMIT terminalRemoved(terminalId);
+    Q_EMIT layoutChanged();
     Q_EMIT wantsBlurChanged();
 
-    cleanup();
+    if (m_terminals.empty() && m_baseSplitter)
+        m_baseSplitter->deleteLater();
 }
 
-void Session::cleanup()
+void Session::prepareShutdown()
 {
-    if (!m_baseSplitter)
+    m_baseSplitter = nullptr;
+
+    deleteLater();
+}
+
+void Session::materialize()
+{
+    if (!m_deferTerminals)
         return;
 
-    m_baseSplitter->recursiveCleanup();
+    m_deferTerminals = false;
 
-    if (m_terminals.empty())
-        m_baseSplitter->deleteLater();
+    for (auto &[id, terminal] : m_terminals) {
+        terminal->materialize();
+    }
+
+    Terminal *terminal = getTerminal(m_activeTerminalId);
+
+    if (terminal && terminal->terminalWidget())
+        terminal->terminalWidget()->setFocus();
 }
 
-void Session::prepareShutdown()
+bool Session::hibernate()
 {
-    m_baseSplitter = nullptr;
+    if (m_deferTerminals || m_terminals.empty())
+        return false;
 
-    deleteLater();
+    // A session is either loaded or deferred as a whole.
+    for (auto &[id, terminal] : m_terminals) {
+        if (!terminal->canHibernate())
+            return false;
+    }
+
+    unzoom();
+
+    m_deferTerminals = true;
+
+    for (auto &[id, terminal] : m_terminals) {
+        terminal->hibernate();
+    }
+
+    return true;
 }
 
 const QString Session::terminalIdList()
@@ -419,6 +852,58 @@ const QString Session::terminalIdList()
     return idList.join(QLatin1Char(','));
 }
 
+QVariantMap Session::layoutState()
+{
+    if (!m_baseSplitter)
+        return QVariantMap();
+
+    return layoutState(m_layout.root());
+}
+
+QVariantMap Session::layoutState(LayoutTree::Node *node)
+{
+    QVariantMap state;
+
+    if (!node->isTerminal()) {
+        // Describing the layout leaves the tree as it is.
+        const QList<int> splitterSizes = splitSizes(node);
+
+        QVariantList sizes;
+        QVariantList children;
+
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            sizes << splitterSizes.value(int(i), 1);
+            children << layoutState(node->children[i].get());
+        }
+
+        state[QStringLiteral("orientation")] = (node->orientation == Qt::Horizontal) ? QStringLiteral("horizontal") : QStringLiteral("vertical");
+        state[QStringLiteral("sizes")] = sizes;
+        state[QStringLiteral("children")] = children;
+    } else if (Terminal *terminal = getTerminal(node->terminalId)) {
+        state[QStringLiteral("terminalId")] = terminal->id();
+        state[QStringLiteral("title")] = terminal->title();
+        state[QStringLiteral("workingDirectory")] = terminal->currentWorkingDirectory();
+        state[QStringLiteral("active")] = (terminal->id() == m_activeTerminalId);
+        state[QStringLiteral("keyboardInputEnabled")] = terminal->keyboardInputEnabled();
+        state[QStringLiteral("monitorActivityEnabled")] = terminal->monitorActivityEnabled();
+        state[QStringLiteral("monitorSilenceEnabled")] = terminal->monitorSilenceEnabled();
+    }
+
+    return state;
+}
+
+QList<int> Session::terminalIds() const
+{
+    QList<int> ids;
+    ids.reserve(m_terminals.size());
+
+    for (auto &[id, terminal] : m_terminals) {
+        ids << id;
+    }
+
+    return ids;
+}
+
 bool Session::hasTerminal(int terminalId)
 {
     return m_terminals.contains(terminalId);
@@ -8,11 +8,18 @@
 #ifndef SESSION_H
 #define SESSION_H
 
+#include "layouttree.h"
 #include "splitter.h"
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVariantMap>
 
 class Terminal;
+class TerminalPool;
 
 class Session : public QObject
 {
@@ -32,9 +39,25 @@ public:
         Left,
     };
 
-    explicit Session(const QString &workingDir, SessionType type = Single, QWidget *parent = nullptr);
+    /**
+     * Builds the splitters and terminals described by @p layout in one
+     * pass. A node with "children" is a splitter with an "orientation"
+     * ("horizontal" or "vertical") and optional "ratios" (or "sizes") to
+     * share its space by; any other node is a terminal with an optional
+     * "workingDirectory", a "command" to run (unless built without the
+     * runCommand D-Bus methods), "active" to make it the active terminal
+     * and the keyboard input and monitoring flags. An empty layout is a
+     * single terminal.
+     */
+    explicit Session(const QString &workingDir,
+                     const QVariantMap &layout = QVariantMap(),
+                     TerminalPool *terminalPool = nullptr,
+                     bool deferTerminals = false,
+                     QWidget *parent = nullptr);
     ~Session() override;
 
+    static QVariantMap layoutForType(SessionType type);
+
     int id() const
     {
         return m_sessionId;
@@ -53,6 +76,7 @@ public:
         return m_activeTerminalId;
     }
     const QString terminalIdList();
+    QList<int> terminalIds() const;
     int terminalCount() const
     {
         return m_terminals.size();
@@ -92,6 +116,31 @@ public:
 
     bool wantsBlur() const;
 
+    int zoomedTerminalId() const
+    {
+        return m_zoomedTerminalId;
+    }
+
+    bool isDeferred() const
+    {
+        return m_deferTerminals;
+    }
+    void materialize();
+
+    /**
+     * Unloads the terminals of a session whose shells are all idle, they
+     * are loaded again like those of a deferred session. Returns whether
+     * the session was hibernated.
+     */
+    bool hibernate();
+
+    /**
+     * Describes the split layout as nested maps: splitters carry their
+     * orientation, child sizes and children, terminals their id, title,
+     * working directory and flags.
+     */
+    QVariantMap layoutState();
+
 public Q_SLOTS:
     void closeTerminal(int terminalId = -1);
 
@@ -104,6 +153,12 @@ public Q_SLOTS:
 
     int tryGrowTerminal(int terminalId, GrowthDirection direction, uint pixels);
 
+    int focusTerminal(int terminalId, GrowthDirection direction);
+
+    bool toggleZoom(int terminalId = -1);
+
+    void rebalance(LayoutTree::Balance balance, const QHash<int, qreal> &weights = QHash<int, qreal>());
+
     void runCommand(const QString &command, int terminalId = -1);
 
     void manageProfiles();
@@ -120,33 +175,69 @@ Q_SIGNALS:
     void silenceDetected(Terminal *terminal);
     void destroyed(int sessionId);
     void wantsBlurChanged();
+    void terminalAdded(int terminalId);
+    void terminalRemoved(int terminalId);
+    void layoutChanged();
 
 private Q_SLOTS:
     void setActiveTerminal(int terminalId);
     void setTitle(int terminalId, const QString &title);
+    void emitTitle();
 
     void cleanup(int terminalId);
-    void cleanup();
     void prepareShutdown();
 
 private:
-    void setupSession(SessionType type);
-
-    Terminal *addTerminal(QSplitter *parent, QString workingDir = QString());
+    void setupLayout(LayoutTree::Node *split, const QVariantMap &layout, Terminal *&activeTerminal);
+    Terminal *addLayoutTerminal(LayoutTree::Node *split, const QVariantMap &pane);
+
+    Splitter *addSplitter(LayoutTree::Node *split, QWidget *parent);
+    void setSplitSizes(LayoutTree::Node *split, const QList<int> &sizes);
+    QList<int> splitSizes(LayoutTree::Node *split) const;
+    void updateSplitSizes(LayoutTree::Node *split);
+    void updateSplitter(LayoutTree::Node *split);
+    void applySplitSizes(LayoutTree::Node *split);
+
+    Terminal *addTerminal(LayoutTree::Node *split, QString workingDir = QString());
+    QVariantMap layoutState(LayoutTree::Node *node);
     int split(Terminal *terminal, Qt::Orientation orientation);
 
+    void zoom(int terminalId);
+    void unzoom();
+
     QString m_workingDir;
     static int m_availableSessionId;
     int m_sessionId;
 
     Splitter *m_baseSplitter = nullptr;
 
+    // The layout is kept in the tree, the splitters merely show it.
+    LayoutTree m_layout;
+    QHash<LayoutTree::Node *, QPointer<Splitter>> m_splitters;
+    QHash<Splitter *, LayoutTree::Node *> m_splitterNodes;
+
+    TerminalPool *m_terminalPool = nullptr;
+    bool m_deferTerminals = false;
+
     int m_activeTerminalId;
     std::map<int, std::unique_ptr<Terminal>> m_terminals;
 
     QString m_title;
 
+    // Title changes are coalesced to at most one per TitleUpdateInterval.
+    QString m_emittedTitle;
+    QTimer m_titleTimer;
+    QElapsedTimer m_titleClock;
+
     bool m_closable;
+
+    // While a terminal is zoomed everything else is hidden, the split
+    // sizes in the layout tree are those to restore.
+    int m_zoomedTerminalId = -1;
+
+    // Spatial index of the terminals, rebuilt on the first lookup after the layout changed.
+    QHash<int, LayoutTree::Neighbors> m_neighbors;
+    bool m_neighborsValid = false;
 };
 
 #endif
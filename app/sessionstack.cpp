@@ -8,6 +8,7 @@
 #include "sessionstack.h"
 #include "settings.h"
 #include "terminal.h"
+#include "terminalpool.h"
 #include "visualeventoverlay.h"
 
 #include <KLocalizedString>
@@ -15,31 +16,87 @@
 #include <KNotification>
 
 #include <QDBusConnection>
+#include <QFile>
 
 #include <algorithm>
 
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
 static bool show_disallow_certain_dbus_methods_message = true;
 
+static bool layoutHasCommands(const QVariantMap &layout)
+{
+    if (!layout.value(QStringLiteral("command")).toString().isEmpty())
+        return true;
+
+    const QVariantList children = layout.value(QStringLiteral("children")).toList();
+
+    return std::any_of(children.cbegin(), children.cend(), [](const QVariant &child) {
+        return layoutHasCommands(child.toMap());
+    });
+}
+
+static void warnAboutDBus()
+{
+#if !defined(REMOVE_SENDTEXT_RUNCOMMAND_DBUS_METHODS)
+    if (show_disallow_certain_dbus_methods_message) {
+        KNotification::event(
+            KNotification::Warning,
+            QStringLiteral("Yakuake D-Bus Warning"),
+            i18n("The D-Bus method runCommand was just used.  There are security concerns about allowing these methods to be public.  If desired, these "
+                 "methods can be changed to internal use only by re-compiling Yakuake. <p>This warning will only show once for this Yakuake instance.</p>"));
+        show_disallow_certain_dbus_methods_message = false;
+    }
+#endif
+}
+
 SessionStack::SessionStack(QWidget *parent)
     : QStackedWidget(parent)
 {
-    QDBusConnection::sessionBus().registerObject(QStringLiteral("/yakuake/sessions"), this, QDBusConnection::ExportScriptableSlots);
+    new SessionStackAdaptor(this);
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/yakuake/sessions"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots | QDBusConnection::ExportAdaptors);
 
     m_activeSessionId = -1;
 
     m_visualEventOverlay = new VisualEventOverlay(this);
     connect(this, SIGNAL(removeTerminalHighlight()), m_visualEventOverlay, SLOT(removeTerminalHighlight()));
+
+    m_terminalPool = new TerminalPool(this);
+
+    m_memoryTimer.setInterval(30 * 1000);
+    connect(&m_memoryTimer, &QTimer::timeout, this, &SessionStack::governMemory);
+
+    connect(Settings::self(), &Settings::configChanged, this, &SessionStack::applyMemorySettings);
+    applyMemorySettings();
 }
 
 SessionStack::~SessionStack() = default;
 
 int SessionStack::addSessionImpl(Session::SessionType type)
 {
+    return addSessionWithLayout(Session::layoutForType(type));
+}
+
+int SessionStack::addSessionWithLayout(const QVariantMap &layout, bool deferTerminals)
+{
+    // Commands in a layout are run just like through runCommand().
+    if (layoutHasCommands(layout))
+        warnAboutDBus();
+
     Session *currentSession = m_sessions.value(activeSessionId());
     Terminal *currentTerminal = currentSession ? currentSession->getTerminal(currentSession->activeTerminalId()) : nullptr;
     QString workingDir = currentTerminal ? currentTerminal->currentWorkingDirectory() : QString();
 
-    Session *session = new Session(workingDir, type, this);
+    // Sessions added while the window is hidden, e.g. at startup or through
+    // D-Bus, only load their terminals once they are actually shown.
+    if (Settings::deferTerminalLoading() && !isVisible())
+        deferTerminals = true;
+
+    Session *session = new Session(workingDir, layout, m_terminalPool, deferTerminals, this);
     // clang-format off
     connect(session, SIGNAL(titleChanged(int,QString)), this, SIGNAL(titleChanged(int,QString)));
     connect(session, SIGNAL(terminalManuallyActivated(Terminal*)), this, SLOT(handleManualTerminalActivation(Terminal*)));
@@ -50,10 +107,26 @@ int SessionStack::addSessionImpl(Session::SessionType type)
     // clang-format on
     connect(session, SIGNAL(destroyed(int)), this, SLOT(cleanup(int)));
     connect(session, &Session::wantsBlurChanged, this, &SessionStack::wantsBlurChanged);
+    connect(session, &Session::terminalAdded, this, [this, session](int terminalId) {
+        m_terminalSessions.insert(terminalId, session);
+    });
+    connect(session, &Session::terminalRemoved, this, [this](int terminalId) {
+        m_terminalSessions.remove(terminalId);
+    });
+    connect(session, &Session::layoutChanged, this, [this, session]() {
+        Q_EMIT sessionChanged(session->id());
+    });
+
+    // The session's initial terminals were added before we could listen.
+    const QList<int> terminalIds = session->terminalIds();
+
+    for (int terminalId : terminalIds)
+        m_terminalSessions.insert(terminalId, session);
 
     addWidget(session->widget());
 
     m_sessions.insert(session->id(), session);
+    m_sessionClocks[session->id()].start();
 
     Q_EMIT wantsBlurChanged();
 
@@ -104,12 +177,19 @@ void SessionStack::raiseSession(int sessionId)
         disconnect(oldActiveSession, SIGNAL(titleChanged(QString)), this, SIGNAL(activeTitleChanged(QString)));
 
         oldActiveSession->reconnectMonitorActivitySignals();
+
+        m_sessionClocks[m_activeSessionId].start();
     }
 
     m_activeSessionId = sessionId;
 
+    m_sessionClocks[sessionId].start();
+
     setCurrentWidget(session->widget());
 
+    if (isVisible())
+        session->materialize();
+
     if (session->widget()->focusWidget())
         session->widget()->focusWidget()->setFocus();
 
@@ -153,6 +233,9 @@ void SessionStack::removeTerminal(int terminalId)
         if (m_sessions.value(m_activeSessionId)->closable())
             m_sessions.value(m_activeSessionId)->closeTerminal();
     } else {
+        if (sessionId == -1)
+            return;
+
         if (m_sessions.value(sessionId)->closable())
             m_sessions.value(sessionId)->closeTerminal(terminalId);
     }
@@ -176,12 +259,105 @@ void SessionStack::cleanup(int sessionId)
     if (sessionId == m_activeSessionId)
         m_activeSessionId = -1;
 
-    m_sessions.remove(sessionId);
+    Session *session = m_sessions.take(sessionId);
+    m_sessionClocks.remove(sessionId);
+
+    m_terminalSessions.removeIf([session](QHash<int, Session *>::iterator it) {
+        return it.value() == session;
+    });
 
     Q_EMIT wantsBlurChanged();
     Q_EMIT sessionRemoved(sessionId);
 }
 
+static qint64 residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile statm(QStringLiteral("/proc/self/statm"));
+
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+
+    // Total program size, then resident pages.
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+
+    if (fields.count() < 2)
+        return -1;
+
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+QVariantMap SessionStack::memoryUsage() const
+{
+    QVariantList sessions;
+
+    const QList<int> ids = sessionIds();
+
+    for (int sessionId : ids) {
+        Session *session = m_sessions.value(sessionId);
+        const QElapsedTimer clock = m_sessionClocks.value(sessionId);
+
+        QVariantMap sessionUsage;
+        sessionUsage[QStringLiteral("sessionId")] = sessionId;
+        sessionUsage[QStringLiteral("terminalCount")] = session->terminalCount();
+        sessionUsage[QStringLiteral("loaded")] = !session->isDeferred();
+        sessionUsage[QStringLiteral("idleSeconds")] = (sessionId == m_activeSessionId || !clock.isValid()) ? 0 : clock.elapsed() / 1000;
+
+        sessions << sessionUsage;
+    }
+
+    QVariantMap usage;
+    usage[QStringLiteral("residentBytes")] = residentMemory();
+    usage[QStringLiteral("budgetBytes")] = qint64(Settings::memoryBudget()) * 1024 * 1024;
+    usage[QStringLiteral("sessions")] = sessions;
+
+    return usage;
+}
+
+void SessionStack::applyMemorySettings()
+{
+    if (Settings::memoryBudget() > 0) {
+        if (!m_memoryTimer.isActive())
+            m_memoryTimer.start();
+    } else {
+        m_memoryTimer.stop();
+    }
+}
+
+void SessionStack::governMemory()
+{
+    const qint64 budget = qint64(Settings::memoryBudget()) * 1024 * 1024;
+    const qint64 resident = residentMemory();
+
+    if (budget <= 0 || resident <= budget)
+        return;
+
+    const qint64 idleTime = qint64(Settings::hibernateIdleSeconds()) * 1000;
+
+    QList<int> ids = m_sessions.keys();
+    ids.removeAll(m_activeSessionId);
+
+    // Least recently shown first.
+    std::sort(ids.begin(), ids.end(), [this](int a, int b) {
+        return m_sessionClocks.value(a).elapsed() > m_sessionClocks.value(b).elapsed();
+    });
+
+    // One session at a time, the resident size is measured again on the
+    // next run before anything else is unloaded.
+    for (int sessionId : std::as_const(ids)) {
+        const QElapsedTimer clock = m_sessionClocks.value(sessionId);
+
+        if (!clock.isValid() || clock.elapsed() < idleTime)
+            break;
+
+        if (m_sessions.value(sessionId)->hibernate())
+            return;
+    }
+}
+
 int SessionStack::activeTerminalId()
 {
     if (!m_sessions.contains(m_activeSessionId))
@@ -190,73 +366,119 @@ int SessionStack::activeTerminalId()
     return m_sessions.value(m_activeSessionId)->activeTerminalId();
 }
 
-const QString SessionStack::sessionIdList()
+int SessionStack::activeTerminalIdForSession(int sessionId) const
+{
+    Session *session = m_sessions.value(sessionId);
+
+    return session ? session->activeTerminalId() : -1;
+}
+
+static QString joinIds(const QList<int> &ids)
 {
-    QList<int> keyList = m_sessions.keys();
-    QStringList idList;
+    QString idList;
 
-    QListIterator<int> i(keyList);
+    for (int id : ids) {
+        if (!idList.isEmpty())
+            idList += QLatin1Char(',');
 
-    while (i.hasNext())
-        idList << QString::number(i.next());
+        idList += QString::number(id);
+    }
 
-    return idList.join(QLatin1Char(','));
+    return idList;
 }
 
-const QString SessionStack::terminalIdList()
+QList<int> SessionStack::sessionIds() const
 {
-    QStringList idList;
+    QList<int> ids = m_sessions.keys();
+    std::sort(ids.begin(), ids.end());
 
-    QHashIterator<int, Session *> it(m_sessions);
+    return ids;
+}
 
-    while (it.hasNext()) {
-        it.next();
+QList<int> SessionStack::terminalIds() const
+{
+    QList<int> ids;
+    ids.reserve(m_terminalSessions.size());
 
-        idList << it.value()->terminalIdList();
-    }
+    const QList<int> sessions = sessionIds();
+
+    for (int sessionId : sessions)
+        ids << m_sessions.value(sessionId)->terminalIds();
 
-    return idList.join(QLatin1Char(','));
+    return ids;
 }
 
-const QString SessionStack::terminalIdsForSessionId(int sessionId)
+QList<int> SessionStack::terminalIdsForSession(int sessionId) const
 {
-    if (!m_sessions.contains(sessionId))
-        return QString::number(-1);
+    Session *session = m_sessions.value(sessionId);
 
-    return m_sessions.value(sessionId)->terminalIdList();
+    return session ? session->terminalIds() : QList<int>();
 }
 
-int SessionStack::sessionIdForTerminalId(int terminalId)
+SessionInfoList SessionStack::sessionInfos() const
 {
-    int sessionId = -1;
+    SessionInfoList infos;
+    infos.reserve(m_sessions.size());
 
-    QHashIterator<int, Session *> it(m_sessions);
+    const QList<int> sessions = sessionIds();
 
-    while (it.hasNext()) {
-        it.next();
+    for (int sessionId : sessions) {
+        Session *session = m_sessions.value(sessionId);
 
-        if (it.value()->hasTerminal(terminalId)) {
-            sessionId = it.key();
+        SessionInfo info;
+        info.sessionId = sessionId;
+        info.activeTerminalId = session->activeTerminalId();
+        info.terminalIds = session->terminalIds();
+        info.title = session->title();
+        info.closable = session->closable();
 
-            break;
-        }
+        infos << info;
     }
 
-    return sessionId;
+    return infos;
 }
 
-static void warnAboutDBus()
+QVariantMap SessionStack::sessionState(int sessionId) const
 {
-#if !defined(REMOVE_SENDTEXT_RUNCOMMAND_DBUS_METHODS)
-    if (show_disallow_certain_dbus_methods_message) {
-        KNotification::event(
-            KNotification::Warning,
-            QStringLiteral("Yakuake D-Bus Warning"),
-            i18n("The D-Bus method runCommand was just used.  There are security concerns about allowing these methods to be public.  If desired, these "
-                 "methods can be changed to internal use only by re-compiling Yakuake. <p>This warning will only show once for this Yakuake instance.</p>"));
-        show_disallow_certain_dbus_methods_message = false;
-    }
-#endif
+    Session *session = m_sessions.value(sessionId);
+
+    if (!session)
+        return QVariantMap();
+
+    QVariantMap state;
+    state[QStringLiteral("sessionId")] = sessionId;
+    state[QStringLiteral("terminalTitle")] = session->title();
+    state[QStringLiteral("activeTerminalId")] = session->activeTerminalId();
+    state[QStringLiteral("zoomedTerminalId")] = session->zoomedTerminalId();
+    state[QStringLiteral("closable")] = session->closable();
+    state[QStringLiteral("layout")] = session->layoutState();
+
+    return state;
+}
+
+const QString SessionStack::sessionIdList()
+{
+    return joinIds(sessionIds());
+}
+
+const QString SessionStack::terminalIdList()
+{
+    return joinIds(terminalIds());
+}
+
+const QString SessionStack::terminalIdsForSessionId(int sessionId)
+{
+    if (!m_sessions.contains(sessionId))
+        return QString::number(-1);
+
+    return joinIds(terminalIdsForSession(sessionId));
+}
+
+int SessionStack::sessionIdForTerminalId(int terminalId)
+{
+    Session *session = m_terminalSessions.value(terminalId);
+
+    return session ? session->id() : -1;
 }
 
 void SessionStack::runCommand(const QString &command)
@@ -275,13 +497,21 @@ void SessionStack::runCommandInTerminal(int terminalId, const QString &command)
 {
     warnAboutDBus();
 
-    QHashIterator<int, Session *> it(m_sessions);
+    // -1 has always meant the active terminal of every session.
+    if (terminalId == -1) {
+        QHashIterator<int, Session *> it(m_sessions);
 
-    while (it.hasNext()) {
-        it.next();
+        while (it.hasNext()) {
+            it.next();
 
-        it.value()->runCommand(command, terminalId);
+            it.value()->runCommand(command, terminalId);
+        }
+
+        return;
     }
+
+    if (Session *session = m_terminalSessions.value(terminalId))
+        session->runCommand(command, terminalId);
 }
 
 bool SessionStack::isSessionClosable(int sessionId)
@@ -305,7 +535,14 @@ void SessionStack::setSessionClosable(int sessionId, bool closable)
     if (!m_sessions.contains(sessionId))
         return;
 
-    m_sessions.value(sessionId)->setClosable(closable);
+    Session *session = m_sessions.value(sessionId);
+
+    if (session->closable() == closable)
+        return;
+
+    session->setClosable(closable);
+
+    Q_EMIT sessionClosableChanged(sessionId, closable);
 }
 
 bool SessionStack::hasUnclosableSessions() const
@@ -345,6 +582,8 @@ void SessionStack::setSessionKeyboardInputEnabled(int sessionId, bool enabled)
 
     m_sessions.value(sessionId)->setKeyboardInputEnabled(enabled);
 
+    Q_EMIT sessionChanged(sessionId);
+
     if (sessionId == m_activeSessionId) {
         if (enabled)
             m_visualEventOverlay->hide();
@@ -374,6 +613,8 @@ void SessionStack::setTerminalKeyboardInputEnabled(int terminalId, bool enabled)
 
     m_sessions.value(sessionId)->setKeyboardInputEnabled(terminalId, enabled);
 
+    Q_EMIT sessionChanged(sessionId);
+
     if (sessionId == m_activeSessionId) {
         if (enabled)
             m_visualEventOverlay->hide();
@@ -428,6 +669,8 @@ void SessionStack::setSessionMonitorActivityEnabled(int sessionId, bool enabled)
         return;
 
     m_sessions.value(sessionId)->setMonitorActivityEnabled(enabled);
+
+    Q_EMIT sessionChanged(sessionId);
 }
 
 bool SessionStack::isTerminalMonitorActivityEnabled(int terminalId)
@@ -450,6 +693,8 @@ void SessionStack::setTerminalMonitorActivityEnabled(int terminalId, bool enable
         return;
 
     m_sessions.value(sessionId)->setMonitorActivityEnabled(terminalId, enabled);
+
+    Q_EMIT sessionChanged(sessionId);
 }
 
 bool SessionStack::hasTerminalsWithMonitorActivityEnabled(int sessionId)
@@ -498,6 +743,8 @@ void SessionStack::setSessionMonitorSilenceEnabled(int sessionId, bool enabled)
         return;
 
     m_sessions.value(sessionId)->setMonitorSilenceEnabled(enabled);
+
+    Q_EMIT sessionChanged(sessionId);
 }
 
 bool SessionStack::isTerminalMonitorSilenceEnabled(int terminalId)
@@ -520,6 +767,8 @@ void SessionStack::setTerminalMonitorSilenceEnabled(int terminalId, bool enabled
         return;
 
     m_sessions.value(sessionId)->setMonitorSilenceEnabled(terminalId, enabled);
+
+    Q_EMIT sessionChanged(sessionId);
 }
 
 bool SessionStack::hasTerminalsWithMonitorSilenceEnabled(int sessionId)
@@ -649,6 +898,81 @@ int SessionStack::tryGrowTerminalBottom(int terminalId, uint pixels)
     return m_sessions.value(sessionId)->tryGrowTerminal(terminalId, Session::Down, pixels);
 }
 
+int SessionStack::focusTerminalLeft(int terminalId)
+{
+    int sessionId = sessionIdForTerminalId(terminalId);
+
+    if (sessionId == -1)
+        return -1;
+
+    return m_sessions.value(sessionId)->focusTerminal(terminalId, Session::Left);
+}
+
+int SessionStack::focusTerminalRight(int terminalId)
+{
+    int sessionId = sessionIdForTerminalId(terminalId);
+
+    if (sessionId == -1)
+        return -1;
+
+    return m_sessions.value(sessionId)->focusTerminal(terminalId, Session::Right);
+}
+
+int SessionStack::focusTerminalUp(int terminalId)
+{
+    int sessionId = sessionIdForTerminalId(terminalId);
+
+    if (sessionId == -1)
+        return -1;
+
+    return m_sessions.value(sessionId)->focusTerminal(terminalId, Session::Up);
+}
+
+int SessionStack::focusTerminalDown(int terminalId)
+{
+    int sessionId = sessionIdForTerminalId(terminalId);
+
+    if (sessionId == -1)
+        return -1;
+
+    return m_sessions.value(sessionId)->focusTerminal(terminalId, Session::Down);
+}
+
+bool SessionStack::toggleTerminalZoom(int terminalId)
+{
+    int sessionId = sessionIdForTerminalId(terminalId);
+
+    if (sessionId == -1)
+        return false;
+
+    return m_sessions.value(sessionId)->toggleZoom(terminalId);
+}
+
+void SessionStack::rebalanceSession(int sessionId, const QString &mode, const QVariantMap &weights)
+{
+    if (sessionId == -1)
+        return;
+
+    if (!m_sessions.contains(sessionId))
+        return;
+
+    LayoutTree::Balance balance = LayoutTree::Equal;
+
+    if (mode == QLatin1String("golden"))
+        balance = LayoutTree::GoldenRatio;
+    else if (mode == QLatin1String("weights"))
+        balance = LayoutTree::Weighted;
+    else if (!mode.isEmpty() && mode != QLatin1String("equal"))
+        return;
+
+    QHash<int, qreal> terminalWeights;
+
+    for (auto it = weights.cbegin(); it != weights.cend(); ++it)
+        terminalWeights.insert(it.key().toInt(), it.value().toDouble());
+
+    m_sessions.value(sessionId)->rebalance(balance, terminalWeights);
+}
+
 void SessionStack::emitTitles()
 {
     QString title;
@@ -703,6 +1027,8 @@ void SessionStack::showEvent(QShowEvent *event)
     if (!m_sessions.contains(m_activeSessionId))
         return;
 
+    m_sessions.value(m_activeSessionId)->materialize();
+
     Terminal *terminal = m_sessions.value(m_activeSessionId)->getTerminal(activeTerminalId());
 
     if (terminal) {
@@ -756,10 +1082,10 @@ QList<KActionCollection *> SessionStack::getPartActionCollections()
 
     const auto sessions = m_sessions.values();
     for (auto *session : sessions) {
-        const auto terminalIds = session->terminalIdList().split(QStringLiteral(","));
+        const auto terminalIds = session->terminalIds();
 
-        for (const auto &terminalID : terminalIds) {
-            auto *terminal = session->getTerminal(terminalID.toInt());
+        for (int terminalId : terminalIds) {
+            auto *terminal = session->getTerminal(terminalId);
             if (terminal) {
                 auto *collection = terminal->actionCollection();
                 if (collection) {
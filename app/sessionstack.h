@@ -9,13 +9,17 @@
 #define SESSIONSTACK_H
 
 #include "session.h"
+#include "sessionstackadaptor.h"
 
 #include <config-yakuake.h>
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QStackedWidget>
+#include <QTimer>
 
 class Session;
+class TerminalPool;
 class VisualEventOverlay;
 class KActionCollection;
 
@@ -38,10 +42,18 @@ public:
 
     QList<KActionCollection *> getPartActionCollections();
 
+    QList<int> sessionIds() const;
+    QList<int> terminalIds() const;
+    QList<int> terminalIdsForSession(int sessionId) const;
+    SessionInfoList sessionInfos() const;
+    QVariantMap sessionState(int sessionId) const;
+    int activeTerminalIdForSession(int sessionId) const;
+
     bool wantsBlur() const;
 
 public Q_SLOTS:
     int addSessionImpl(Session::SessionType type = Session::Single);
+    int addSessionWithLayout(const QVariantMap &layout, bool deferTerminals = false);
     Q_SCRIPTABLE int addSession();
     Q_SCRIPTABLE int addSessionTwoHorizontal();
     Q_SCRIPTABLE int addSessionTwoVertical();
@@ -63,6 +75,21 @@ public Q_SLOTS:
     Q_SCRIPTABLE int tryGrowTerminalTop(int terminalId, uint pixels = 10);
     Q_SCRIPTABLE int tryGrowTerminalBottom(int terminalId, uint pixels = 10);
 
+    Q_SCRIPTABLE int focusTerminalLeft(int terminalId);
+    Q_SCRIPTABLE int focusTerminalRight(int terminalId);
+    Q_SCRIPTABLE int focusTerminalUp(int terminalId);
+    Q_SCRIPTABLE int focusTerminalDown(int terminalId);
+
+    Q_SCRIPTABLE bool toggleTerminalZoom(int terminalId);
+
+    /**
+     * Resizes all terminals of the session at once. @p mode is "equal",
+     * "golden" (the active terminal gets the golden share along each
+     * split it is in) or "weights", sharing the space out by the
+     * @p weights given for terminal ids.
+     */
+    Q_SCRIPTABLE void rebalanceSession(int sessionId, const QString &mode = QString(), const QVariantMap &weights = QVariantMap());
+
     Q_SCRIPTABLE int activeSessionId()
     {
         return m_activeSessionId;
@@ -74,6 +101,14 @@ public Q_SLOTS:
     Q_SCRIPTABLE const QString terminalIdsForSessionId(int sessionId);
     Q_SCRIPTABLE int sessionIdForTerminalId(int terminalId);
 
+    /**
+     * Reports the process' resident memory ("residentBytes", -1 where it
+     * can't be determined), the configured "budgetBytes" and, for each
+     * session, its "terminalCount", whether its terminals are "loaded" and
+     * for how many "idleSeconds" it hasn't been shown.
+     */
+    Q_SCRIPTABLE QVariantMap memoryUsage() const;
+
 #if defined(REMOVE_SENDTEXT_RUNCOMMAND_DBUS_METHODS)
     void runCommand(const QString &command);
     void runCommandInTerminal(int terminalId, const QString &command);
@@ -128,6 +163,11 @@ Q_SIGNALS:
 
     void wantsBlurChanged();
 
+    void sessionClosableChanged(int sessionId, bool closable);
+
+    // The split layout or the flags of a session's terminals changed.
+    void sessionChanged(int sessionId);
+
 protected:
     void showEvent(QShowEvent *event) override;
 
@@ -136,6 +176,9 @@ private Q_SLOTS:
 
     void cleanup(int sessionId);
 
+    void applyMemorySettings();
+    void governMemory();
+
 private:
     enum QueryCloseType {
         QueryCloseSession,
@@ -144,10 +187,20 @@ private:
     bool queryClose(int sessionId, QueryCloseType type);
 
     VisualEventOverlay *m_visualEventOverlay = nullptr;
+    TerminalPool *m_terminalPool = nullptr;
 
     int m_activeSessionId;
 
     QHash<int, Session *> m_sessions;
+
+    // Which session each terminal belongs to, kept up to date as terminals
+    // come and go so per-terminal calls don't have to ask every session.
+    QHash<int, Session *> m_terminalSessions;
+
+    // Time since each session was last shown, idle sessions get hibernated
+    // while over the memory budget.
+    QHash<int, QElapsedTimer> m_sessionClocks;
+    QTimer m_memoryTimer;
 };
 
 #endif
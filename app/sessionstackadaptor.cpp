@@ -0,0 +1,60 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "sessionstackadaptor.h"
+#include "sessionstack.h"
+
+#include <QDBusMetaType>
+
+QDBusArgument &operator<<(QDBusArgument &argument, const SessionInfo &info)
+{
+    argument.beginStructure();
+    argument << info.sessionId << info.activeTerminalId << info.terminalIds << info.title << info.closable;
+    argument.endStructure();
+
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, SessionInfo &info)
+{
+    argument.beginStructure();
+    argument >> info.sessionId >> info.activeTerminalId >> info.terminalIds >> info.title >> info.closable;
+    argument.endStructure();
+
+    return argument;
+}
+
+SessionStackAdaptor::SessionStackAdaptor(SessionStack *sessionStack)
+    : QDBusAbstractAdaptor(sessionStack)
+    , m_sessionStack(sessionStack)
+{
+    qDBusRegisterMetaType<SessionInfo>();
+    qDBusRegisterMetaType<SessionInfoList>();
+}
+
+SessionStackAdaptor::~SessionStackAdaptor() = default;
+
+QList<int> SessionStackAdaptor::sessionIds()
+{
+    return m_sessionStack->sessionIds();
+}
+
+QList<int> SessionStackAdaptor::terminalIds()
+{
+    return m_sessionStack->terminalIds();
+}
+
+QList<int> SessionStackAdaptor::terminalIdsForSession(int sessionId)
+{
+    return m_sessionStack->terminalIdsForSession(sessionId);
+}
+
+SessionInfoList SessionStackAdaptor::sessions()
+{
+    return m_sessionStack->sessionInfos();
+}
+
+#include "moc_sessionstackadaptor.cpp"
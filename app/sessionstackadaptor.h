@@ -0,0 +1,58 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef SESSIONSTACKADAPTOR_H
+#define SESSIONSTACKADAPTOR_H
+
+#include <QDBusAbstractAdaptor>
+#include <QDBusArgument>
+#include <QList>
+#include <QString>
+
+class SessionStack;
+
+/**
+ * A session as reported over D-Bus, marshalled as (iiaisb).
+ */
+struct SessionInfo {
+    int sessionId = -1;
+    int activeTerminalId = -1;
+    QList<int> terminalIds;
+    QString title;
+    bool closable = true;
+};
+using SessionInfoList = QList<SessionInfo>;
+
+Q_DECLARE_METATYPE(SessionInfo)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const SessionInfo &info);
+const QDBusArgument &operator>>(const QDBusArgument &argument, SessionInfo &info);
+
+/**
+ * Versioned D-Bus interface of the session stack, returning typed values
+ * instead of the comma-joined id strings of the org.kde.yakuake interface,
+ * whose methods are kept for compatibility.
+ */
+class SessionStackAdaptor : public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.yakuake.Sessions1")
+
+public:
+    explicit SessionStackAdaptor(SessionStack *sessionStack);
+    ~SessionStackAdaptor() override;
+
+public Q_SLOTS:
+    QList<int> sessionIds();
+    QList<int> terminalIds();
+    QList<int> terminalIdsForSession(int sessionId);
+    SessionInfoList sessions();
+
+private:
+    SessionStack *m_sessionStack = nullptr;
+};
+
+#endif
@@ -0,0 +1,83 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "sessionstore.h"
+#include "mainwindow.h"
+#include "settings.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+SessionStore::SessionStore(MainWindow *mainWindow)
+    : QObject(mainWindow)
+{
+    m_mainWindow = mainWindow;
+
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(1000);
+    connect(&m_saveTimer, &QTimer::timeout, this, &SessionStore::save);
+}
+
+SessionStore::~SessionStore() = default;
+
+QVariantMap SessionStore::load()
+{
+    QFile file(fileName());
+
+    if (!file.open(QIODevice::ReadOnly))
+        return QVariantMap();
+
+    m_savedData = file.readAll();
+
+    return QJsonDocument::fromJson(m_savedData).object().toVariantMap();
+}
+
+void SessionStore::scheduleSave()
+{
+    if (!Settings::restoreSessions())
+        return;
+
+    // Changes made in the meantime are picked up by the pending save.
+    if (!m_saveTimer.isActive())
+        m_saveTimer.start();
+}
+
+void SessionStore::save()
+{
+    m_saveTimer.stop();
+
+    if (!Settings::restoreSessions())
+        return;
+
+    const QByteArray data = QJsonDocument(QJsonObject::fromVariantMap(m_mainWindow->state())).toJson(QJsonDocument::Compact);
+
+    if (data == m_savedData)
+        return;
+
+    QDir().mkpath(QFileInfo(fileName()).absolutePath());
+
+    QSaveFile file(fileName());
+
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    file.write(data);
+
+    if (file.commit())
+        m_savedData = data;
+}
+
+QString SessionStore::fileName() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/sessions.json");
+}
+
+#include "moc_sessionstore.cpp"
@@ -0,0 +1,48 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QTimer>
+#include <QVariantMap>
+
+class MainWindow;
+
+/**
+ * Persists the session tree as returned by MainWindow::state() so it
+ * can be restored on the next start.
+ *
+ * Changes are written shortly after they happen rather than only at
+ * exit, at most once per second and only if the saved state actually
+ * differs from what is on disk.
+ */
+class SessionStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SessionStore(MainWindow *mainWindow);
+    ~SessionStore() override;
+
+    QVariantMap load();
+
+public Q_SLOTS:
+    void scheduleSave();
+    void save();
+
+private:
+    QString fileName() const;
+
+    MainWindow *m_mainWindow = nullptr;
+
+    QTimer m_saveTimer;
+    QByteArray m_savedData;
+};
+
+#endif
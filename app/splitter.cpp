@@ -15,22 +15,4 @@ Splitter::Splitter(Qt::Orientation orientation, QWidget *parent)
 
 Splitter::~Splitter() = default;
 
-void Splitter::recursiveCleanup()
-{
-    if (count() == 0)
-        deleteLater();
-    else {
-        QList<Splitter *> list = findChildren<Splitter *>();
-
-        QListIterator<Splitter *> i(list);
-
-        while (i.hasNext()) {
-            Splitter *splitter = i.next();
-
-            if (splitter->parent() == this)
-                splitter->recursiveCleanup();
-        }
-    }
-}
-
 #include "moc_splitter.cpp"
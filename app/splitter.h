@@ -16,8 +16,6 @@ class Splitter : public QSplitter
 public:
     explicit Splitter(Qt::Orientation orientation, QWidget *parent = nullptr);
     ~Splitter() override;
-
-    void recursiveCleanup();
 };
 
 #endif
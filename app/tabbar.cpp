@@ -52,6 +52,8 @@ TabBar::TabBar(MainWindow *mainWindow)
     m_skin = mainWindow->skin();
     connect(m_skin, SIGNAL(iconChanged()), this, SLOT(repaint()));
 
+    updateTabFonts();
+
     m_tabContextMenu = new QMenu(this);
     connect(m_tabContextMenu, SIGNAL(hovered(QAction *)), this, SLOT(contextMenuActionHovered(QAction *)));
 
@@ -94,6 +96,8 @@ TabBar::~TabBar()
 
 void TabBar::applySkin()
 {
+    ++m_skinGeneration;
+
     resize(width(), m_skin->tabBarBackgroundImage().height());
 
     m_newTabButton->setStyleSheet(m_skin->tabBarNewTabButtonStyleSheet());
@@ -182,7 +186,7 @@ void TabBar::updateToggleKeyboardInputMenu(int sessionId)
 
     SessionStack *sessionStack = m_mainWindow->sessionStack();
 
-    QStringList terminalIds = sessionStack->terminalIdsForSessionId(sessionId).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    const QList<int> terminalIds = sessionStack->terminalIdsForSession(sessionId);
 
     m_toggleKeyboardInputMenu->clear();
 
@@ -201,11 +205,7 @@ void TabBar::updateToggleKeyboardInputMenu(int sessionId)
 
         int count = 0;
 
-        QStringListIterator i(terminalIds);
-
-        while (i.hasNext()) {
-            int terminalId = i.next().toInt();
-
+        for (int terminalId : terminalIds) {
             ++count;
 
             QAction *action = m_toggleKeyboardInputMenu->addAction(xi18nc("@action", "For Terminal %1", count));
@@ -227,7 +227,7 @@ void TabBar::updateToggleMonitorActivityMenu(int sessionId)
 
     SessionStack *sessionStack = m_mainWindow->sessionStack();
 
-    QStringList terminalIds = sessionStack->terminalIdsForSessionId(sessionId).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    const QList<int> terminalIds = sessionStack->terminalIdsForSession(sessionId);
 
     m_toggleMonitorActivityMenu->clear();
 
@@ -246,11 +246,7 @@ void TabBar::updateToggleMonitorActivityMenu(int sessionId)
 
         int count = 0;
 
-        QStringListIterator i(terminalIds);
-
-        while (i.hasNext()) {
-            int terminalId = i.next().toInt();
-
+        for (int terminalId : terminalIds) {
             ++count;
 
             QAction *action = m_toggleMonitorActivityMenu->addAction(xi18nc("@action", "In Terminal %1", count));
@@ -272,7 +268,7 @@ void TabBar::updateToggleMonitorSilenceMenu(int sessionId)
 
     SessionStack *sessionStack = m_mainWindow->sessionStack();
 
-    QStringList terminalIds = sessionStack->terminalIdsForSessionId(sessionId).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    const QList<int> terminalIds = sessionStack->terminalIdsForSession(sessionId);
 
     m_toggleMonitorSilenceMenu->clear();
 
@@ -291,11 +287,7 @@ void TabBar::updateToggleMonitorSilenceMenu(int sessionId)
 
         int count = 0;
 
-        QStringListIterator i(terminalIds);
-
-        while (i.hasNext()) {
-            int terminalId = i.next().toInt();
-
+        for (int terminalId : terminalIds) {
             ++count;
 
             QAction *action = m_toggleMonitorSilenceMenu->addAction(xi18nc("@action", "In Terminal %1", count));
@@ -381,7 +373,7 @@ void TabBar::moveNewTabButton()
     m_newTabButton->move(newTabButtonX, m_skin->tabBarNewTabButtonPosition().y());
 }
 
-void TabBar::paintEvent(QPaintEvent *)
+void TabBar::paintEvent(QPaintEvent *event)
 {
     QPainter painter(this);
     painter.setPen(m_skin->tabBarTextColor());
@@ -393,35 +385,26 @@ void TabBar::paintEvent(QPaintEvent *)
     QRect tabsClipRect(x, y, m_closeTabButton->x() - x, height() - y);
     painter.setClipRect(tabsClipRect);
 
+    const int selectedIndex = m_tabs.indexOf(m_selectedSessionId);
+
     for (int index = 0; index < m_tabs.count(); ++index) {
-        x = drawTab(x, y, index, painter);
+        const TabPixmap &tab = tabPixmap(index, selectedIndex);
+
+        if (event->rect().intersects(QRect(x, 0, tab.width, height())))
+            painter.drawPixmap(x, 0, tab.pixmap);
+
+        x += tab.width;
         m_tabWidths << x;
     }
 
-    const QPixmap &backgroundImage = m_skin->tabBarBackgroundImage();
-    const QPixmap &leftCornerImage = m_skin->tabBarLeftCornerImage();
-    const QPixmap &rightCornerImage = m_skin->tabBarRightCornerImage();
-
     x = x > tabsClipRect.right() ? tabsClipRect.right() + 1 : x;
 
     QRegion backgroundClipRegion(rect());
-    backgroundClipRegion = backgroundClipRegion.subtracted(m_newTabButton->geometry());
-    backgroundClipRegion = backgroundClipRegion.subtracted(m_closeTabButton->geometry());
     QRect tabsRect(m_skin->tabBarPosition().x(), y, x - m_skin->tabBarPosition().x(), height() - m_skin->tabBarPosition().y());
     backgroundClipRegion = backgroundClipRegion.subtracted(tabsRect);
     painter.setClipRegion(backgroundClipRegion);
 
-    painter.drawImage(0, 0, leftCornerImage.toImage());
-    QRect leftCornerImageRect(0, 0, leftCornerImage.width(), height());
-    backgroundClipRegion = backgroundClipRegion.subtracted(leftCornerImageRect);
-
-    painter.drawImage(width() - rightCornerImage.width(), 0, rightCornerImage.toImage());
-    QRect rightCornerImageRect(width() - rightCornerImage.width(), 0, rightCornerImage.width(), height());
-    backgroundClipRegion = backgroundClipRegion.subtracted(rightCornerImageRect);
-
-    painter.setClipRegion(backgroundClipRegion);
-
-    painter.drawTiledPixmap(0, 0, width(), height(), backgroundImage);
+    painter.drawPixmap(0, 0, backgroundPixmap());
 
     painter.end();
 
@@ -430,17 +413,12 @@ void TabBar::paintEvent(QPaintEvent *)
     }
 }
 
-int TabBar::drawTab(int x, int y, int index, QPainter &painter)
+int TabBar::drawTab(int x, int y, int index, int selectedIndex, QPainter &painter)
 {
-    QString title;
-    int sessionId;
-    bool selected;
-    QFont font = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
-    int textWidth = 0;
-
-    sessionId = m_tabs.at(index);
-    selected = (sessionId == m_selectedSessionId);
-    title = m_tabTitles[sessionId];
+    int sessionId = m_tabs.at(index);
+    bool selected = (index == selectedIndex);
+    bool bold = selected && m_skin->tabBarSelectedTextBold();
+    const QString title = m_tabTitles.value(sessionId);
 
     if (selected) {
         painter.drawPixmap(x, y, m_skin->tabBarSelectedLeftCornerImage());
@@ -448,23 +426,17 @@ int TabBar::drawTab(int x, int y, int index, QPainter &painter)
     } else if (!m_skin->tabBarUnselectedLeftCornerImage().isNull()) {
         painter.drawPixmap(x, y, m_skin->tabBarUnselectedLeftCornerImage());
         x += m_skin->tabBarUnselectedLeftCornerImage().width();
-    } else if (index != m_tabs.indexOf(m_selectedSessionId) + 1) {
+    } else if (index != selectedIndex + 1) {
         painter.drawPixmap(x, y, m_skin->tabBarSeparatorImage());
         x += m_skin->tabBarSeparatorImage().width();
     }
 
-    if (selected)
-        font.setBold(m_skin->tabBarSelectedTextBold());
-    else
-        font.setBold(false);
-
-    painter.setFont(font);
+    painter.setFont(bold ? m_boldTabFont : m_tabFont);
 
-    QFontMetrics fontMetrics(font);
-    textWidth = fontMetrics.horizontalAdvance(title) + 10;
+    int textWidth = tabTextWidth(sessionId, bold);
 
     // Draw the Prevent Closing image in the tab button.
-    if (m_mainWindow->sessionStack()->isSessionClosable(sessionId) == false) {
+    if (!m_tabLayouts.value(sessionId).closable) {
         if (selected)
             painter.drawTiledPixmap(x,
                                     y,
@@ -501,7 +473,7 @@ int TabBar::drawTab(int x, int y, int index, QPainter &painter)
     } else if (!m_skin->tabBarUnselectedRightCornerImage().isNull()) {
         painter.drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarUnselectedRightCornerImage());
         x += m_skin->tabBarUnselectedRightCornerImage().width();
-    } else if (index != m_tabs.indexOf(m_selectedSessionId) - 1) {
+    } else if (index != selectedIndex - 1) {
         painter.drawPixmap(x, m_skin->tabBarPosition().y(), m_skin->tabBarSeparatorImage());
         x += m_skin->tabBarSeparatorImage().width();
     }
@@ -509,6 +481,168 @@ int TabBar::drawTab(int x, int y, int index, QPainter &painter)
     return x;
 }
 
+const TabBar::TabPixmap &TabBar::tabPixmap(int index, int selectedIndex)
+{
+    const int sessionId = m_tabs.at(index);
+    const QString title = m_tabTitles.value(sessionId);
+    const bool selected = (index == selectedIndex);
+    const bool closable = m_tabLayouts.value(sessionId).closable;
+    const bool leftSeparator = (index != selectedIndex + 1);
+    const bool rightSeparator = (index != selectedIndex - 1);
+    const qreal devicePixelRatio = devicePixelRatioF();
+
+    TabPixmap &tab = m_tabPixmaps[sessionId];
+
+    if (!tab.pixmap.isNull() && tab.title == title && tab.selected == selected && tab.closable == closable && tab.leftSeparator == leftSeparator
+        && tab.rightSeparator == rightSeparator && tab.skinGeneration == m_skinGeneration && tab.devicePixelRatio == devicePixelRatio
+        && tab.height == height()) {
+        return tab;
+    }
+
+    tab.width = tabWidth(index, selectedIndex);
+    tab.title = title;
+    tab.selected = selected;
+    tab.closable = closable;
+    tab.leftSeparator = leftSeparator;
+    tab.rightSeparator = rightSeparator;
+    tab.skinGeneration = m_skinGeneration;
+    tab.devicePixelRatio = devicePixelRatio;
+    tab.height = height();
+
+    // The tab is drawn at the same vertical offset as on the tab bar, so the
+    // pixmap can be blitted at the top of it.
+    tab.pixmap = QPixmap(QSize(qMax(1, tab.width), qMax(1, tab.height)) * devicePixelRatio);
+    tab.pixmap.setDevicePixelRatio(devicePixelRatio);
+    tab.pixmap.fill(Qt::transparent);
+
+    QPainter painter(&tab.pixmap);
+    painter.setPen(m_skin->tabBarTextColor());
+    drawTab(0, m_skin->tabBarPosition().y(), index, selectedIndex, painter);
+
+    return tab;
+}
+
+int TabBar::tabWidth(int index, int selectedIndex)
+{
+    // Has to match the advances made by drawTab().
+    int sessionId = m_tabs.at(index);
+    bool selected = (index == selectedIndex);
+    int width = 0;
+
+    if (selected)
+        width += m_skin->tabBarSelectedLeftCornerImage().width();
+    else if (!m_skin->tabBarUnselectedLeftCornerImage().isNull())
+        width += m_skin->tabBarUnselectedLeftCornerImage().width();
+    else if (index != selectedIndex + 1)
+        width += m_skin->tabBarSeparatorImage().width();
+
+    if (!m_tabLayouts.value(sessionId).closable)
+        width += m_skin->tabBarPreventClosingImagePosition().x() + m_skin->tabBarPreventClosingImage().width();
+
+    width += tabTextWidth(sessionId, selected && m_skin->tabBarSelectedTextBold());
+
+    if (selected)
+        width += m_skin->tabBarSelectedRightCornerImage().width();
+    else if (!m_skin->tabBarUnselectedRightCornerImage().isNull())
+        width += m_skin->tabBarUnselectedRightCornerImage().width();
+    else if (index != selectedIndex - 1)
+        width += m_skin->tabBarSeparatorImage().width();
+
+    return width;
+}
+
+int TabBar::tabTextWidth(int sessionId, bool bold)
+{
+    TabLayout &layout = m_tabLayouts[sessionId];
+    int &textWidth = bold ? layout.boldTextWidth : layout.textWidth;
+
+    if (textWidth < 0)
+        textWidth = QFontMetrics(bold ? m_boldTabFont : m_tabFont).horizontalAdvance(m_tabTitles.value(sessionId)) + 10;
+
+    return textWidth;
+}
+
+void TabBar::updateTabFonts()
+{
+    m_tabFont = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
+    m_tabFont.setBold(false);
+
+    m_boldTabFont = m_tabFont;
+    m_boldTabFont.setBold(true);
+
+    for (auto it = m_tabLayouts.begin(); it != m_tabLayouts.end(); ++it) {
+        it->textWidth = -1;
+        it->boldTextWidth = -1;
+    }
+
+    ++m_skinGeneration;
+}
+
+const QPixmap &TabBar::backgroundPixmap()
+{
+    const qreal devicePixelRatio = devicePixelRatioF();
+
+    if (!m_backgroundPixmap.isNull() && m_backgroundPixmap.deviceIndependentSize().toSize() == size()
+        && m_backgroundPixmap.devicePixelRatio() == devicePixelRatio && m_backgroundSkinGeneration == m_skinGeneration
+        && m_backgroundNewTabButtonGeometry == m_newTabButton->geometry() && m_backgroundCloseTabButtonGeometry == m_closeTabButton->geometry()) {
+        return m_backgroundPixmap;
+    }
+
+    m_backgroundSkinGeneration = m_skinGeneration;
+    m_backgroundNewTabButtonGeometry = m_newTabButton->geometry();
+    m_backgroundCloseTabButtonGeometry = m_closeTabButton->geometry();
+
+    m_backgroundPixmap = QPixmap(size().expandedTo(QSize(1, 1)) * devicePixelRatio);
+    m_backgroundPixmap.setDevicePixelRatio(devicePixelRatio);
+    m_backgroundPixmap.fill(Qt::transparent);
+
+    const QPixmap &backgroundImage = m_skin->tabBarBackgroundImage();
+    const QPixmap &leftCornerImage = m_skin->tabBarLeftCornerImage();
+    const QPixmap &rightCornerImage = m_skin->tabBarRightCornerImage();
+
+    QPainter painter(&m_backgroundPixmap);
+
+    QRegion backgroundClipRegion(rect());
+    backgroundClipRegion = backgroundClipRegion.subtracted(m_newTabButton->geometry());
+    backgroundClipRegion = backgroundClipRegion.subtracted(m_closeTabButton->geometry());
+    painter.setClipRegion(backgroundClipRegion);
+
+    painter.drawPixmap(0, 0, leftCornerImage);
+    QRect leftCornerImageRect(0, 0, leftCornerImage.width(), height());
+    backgroundClipRegion = backgroundClipRegion.subtracted(leftCornerImageRect);
+
+    painter.drawPixmap(width() - rightCornerImage.width(), 0, rightCornerImage);
+    QRect rightCornerImageRect(width() - rightCornerImage.width(), 0, rightCornerImage.width(), height());
+    backgroundClipRegion = backgroundClipRegion.subtracted(rightCornerImageRect);
+
+    painter.setClipRegion(backgroundClipRegion);
+
+    painter.drawTiledPixmap(0, 0, width(), height(), backgroundImage);
+
+    return m_backgroundPixmap;
+}
+
+void TabBar::updateTab(int index)
+{
+    // The last paint's layout is needed to know where the tab was.
+    if (m_tabWidths.count() != m_tabs.count()) {
+        update();
+        return;
+    }
+
+    if (index < 0 || index >= m_tabs.count())
+        return;
+
+    int left = index ? m_tabWidths.at(index - 1) : m_skin->tabBarPosition().x();
+    int right = m_tabWidths.at(index);
+
+    // If the tab changed size, everything to the right of it moves too.
+    if (left + tabWidth(index, m_tabs.indexOf(m_selectedSessionId)) == right)
+        update(left, 0, right - left, height());
+    else
+        update(left, 0, width() - left, height());
+}
+
 int TabBar::tabAt(int x)
 {
     for (int index = 0; index < m_tabWidths.count(); ++index) {
@@ -668,6 +802,7 @@ void TabBar::dropEvent(QDropEvent *event)
             --targetIndex;
 
         m_tabs.move(sourceIndex, targetIndex);
+        Q_EMIT tabMoved(sourceSessionId, targetIndex);
         Q_EMIT tabSelected(m_tabs.at(targetIndex));
 
         event->accept();
@@ -698,6 +833,16 @@ void TabBar::mouseDoubleClickEvent(QMouseEvent *event)
     QWidget::mouseDoubleClickEvent(event);
 }
 
+void TabBar::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange || event->type() == QEvent::ApplicationFontChange) {
+        updateTabFonts();
+        update();
+    }
+
+    QWidget::changeEvent(event);
+}
+
 void TabBar::leaveEvent(QEvent *event)
 {
     m_mousePressed = false;
@@ -716,6 +861,10 @@ void TabBar::addTab(int sessionId, const QString &title)
     else
         m_tabTitles.insert(sessionId, title);
 
+    TabLayout layout;
+    layout.closable = m_mainWindow->sessionStack()->isSessionClosable(sessionId);
+    m_tabLayouts.insert(sessionId, layout);
+
     Q_EMIT tabSelected(sessionId);
 }
 
@@ -735,6 +884,8 @@ void TabBar::removeTab(int sessionId)
 
     m_tabs.removeAt(index);
     m_tabTitles.remove(sessionId);
+    m_tabLayouts.remove(sessionId);
+    m_tabPixmaps.remove(sessionId);
 
     if (m_tabs.isEmpty())
         Q_EMIT lastTabClosed();
@@ -779,12 +930,24 @@ void TabBar::selectTab(int sessionId)
     if (!m_tabs.contains(sessionId))
         return;
 
+    int previousIndex = m_tabs.indexOf(m_selectedSessionId);
+    int index = m_tabs.indexOf(sessionId);
+
     m_selectedSessionId = sessionId;
 
-    updateMoveActions(m_tabs.indexOf(sessionId));
+    updateMoveActions(index);
     updateToggleActions(sessionId);
 
-    repaint();
+    // Only the tabs around the previous and new selection change, as
+    // separators are not drawn next to the selected tab.
+    if (previousIndex == -1) {
+        repaint();
+    } else {
+        for (int i = -1; i <= 1; ++i) {
+            updateTab(previousIndex + i);
+            updateTab(index + i);
+        }
+    }
 }
 
 void TabBar::selectNextTab()
@@ -832,6 +995,8 @@ void TabBar::moveTabLeft(int sessionId)
     repaint();
 
     updateMoveActions(index - 1);
+
+    Q_EMIT tabMoved(sessionId, index - 1);
 }
 
 void TabBar::moveTabRight(int sessionId)
@@ -849,6 +1014,8 @@ void TabBar::moveTabRight(int sessionId)
     repaint();
 
     updateMoveActions(index + 1);
+
+    Q_EMIT tabMoved(sessionId, index + 1);
 }
 
 void TabBar::closeTabButtonClicked()
@@ -877,11 +1044,15 @@ void TabBar::setTabTitle(int sessionId, const QString &newTitle, InteractiveType
 
     if (!newTitle.isEmpty()) {
         m_tabTitles[sessionId] = newTitle;
+
+        TabLayout &layout = m_tabLayouts[sessionId];
+        layout.textWidth = -1;
+        layout.boldTextWidth = -1;
     } else
         m_tabTitlesSetInteractive.remove(sessionId);
 
     Q_EMIT tabTitleEdited(sessionId, newTitle);
-    update();
+    updateTab(m_tabs.indexOf(sessionId));
 }
 
 void TabBar::setTabTitleAutomated(int sessionId, const QString &newTitle)
@@ -889,6 +1060,21 @@ void TabBar::setTabTitleAutomated(int sessionId, const QString &newTitle)
     setTabTitle(sessionId, newTitle, NonInteractive);
 }
 
+bool TabBar::isTabTitleSetInteractively(int sessionId) const
+{
+    return m_tabTitlesSetInteractive.value(sessionId, false);
+}
+
+void TabBar::setTabClosable(int sessionId, bool closable)
+{
+    if (!m_tabLayouts.contains(sessionId))
+        return;
+
+    // So the lock icon is added to or removed from the tab label.
+    m_tabLayouts[sessionId].closable = closable;
+    updateTab(m_tabs.indexOf(sessionId));
+}
+
 int TabBar::sessionAtTab(int index)
 {
     if (index < 0 || index > m_tabs.count() - 1)
@@ -958,7 +1144,7 @@ void TabBar::startDrag(int index)
     painter.begin(this);
     painter.setPen(m_skin->tabBarTextColor());
 
-    drawTab(0, 0, index, painter);
+    drawTab(0, 0, index, m_tabs.indexOf(m_selectedSessionId), painter);
     painter.end();
 
     QMimeData *mimeData = new QMimeData;
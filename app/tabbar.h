@@ -8,8 +8,10 @@
 #ifndef TABBAR_H
 #define TABBAR_H
 
+#include <QFont>
 #include <QHash>
 #include <QList>
+#include <QPixmap>
 #include <QWidget>
 
 class MainWindow;
@@ -36,6 +38,8 @@ public:
 
     void applySkin();
 
+    bool isTabTitleSetInteractively(int sessionId) const;
+
 public Q_SLOTS:
     void addTab(int sessionId, const QString &title);
     void removeTab(int sessionId = -1);
@@ -52,6 +56,7 @@ public Q_SLOTS:
     Q_SCRIPTABLE QString tabTitle(int sessionId);
     Q_SCRIPTABLE void setTabTitle(int sessionId, const QString &newTitle, InteractiveType interactive = Interactive);
     void setTabTitleAutomated(int sessionId, const QString &newTitle);
+    void setTabClosable(int sessionId, bool closable);
 
     Q_SCRIPTABLE int sessionAtTab(int index);
 
@@ -65,6 +70,7 @@ Q_SIGNALS:
     void tabContextMenuClosed();
     void lastTabClosed();
     void tabTitleEdited(int sessionId, QString title);
+    void tabMoved(int sessionId, int index);
 
 protected:
     void resizeEvent(QResizeEvent *) override;
@@ -81,6 +87,7 @@ protected:
     void mouseDoubleClickEvent(QMouseEvent *) override;
     void contextMenuEvent(QContextMenuEvent *) override;
     void leaveEvent(QEvent *) override;
+    void changeEvent(QEvent *) override;
 
 private Q_SLOTS:
     void readySessionMenu();
@@ -104,7 +111,15 @@ private:
     void updateToggleMonitorSilenceMenu(int sessionId = -1);
     void updateToggleMonitorActivityMenu(int sessionId = -1);
 
-    int drawTab(int x, int y, int index, QPainter &painter);
+    struct TabPixmap;
+
+    int drawTab(int x, int y, int index, int selectedIndex, QPainter &painter);
+    const TabPixmap &tabPixmap(int index, int selectedIndex);
+    int tabWidth(int index, int selectedIndex);
+    int tabTextWidth(int sessionId, bool bold);
+    void updateTabFonts();
+    void updateTab(int index);
+    const QPixmap &backgroundPixmap();
     void moveNewTabButton();
 
     void startDrag(int index);
@@ -132,6 +147,43 @@ private:
     QHash<int, bool> m_tabTitlesSetInteractive;
     QList<int> m_tabWidths;
 
+    // Measurements that only change with the title or the fonts, so
+    // painting doesn't need to measure text for every tab.
+    struct TabLayout {
+        int textWidth = -1;
+        int boldTextWidth = -1;
+        bool closable = true;
+    };
+    QHash<int, TabLayout> m_tabLayouts;
+
+    QFont m_tabFont;
+    QFont m_boldTabFont;
+
+    // Rendered tabs, along with everything their pixels depend on.
+    struct TabPixmap {
+        QPixmap pixmap;
+        int width = 0;
+        QString title;
+        bool selected = false;
+        bool closable = true;
+        bool leftSeparator = false;
+        bool rightSeparator = false;
+        uint skinGeneration = 0;
+        qreal devicePixelRatio = 0;
+        int height = 0;
+    };
+    QHash<int, TabPixmap> m_tabPixmaps;
+
+    // Bumped whenever the skin or the fonts change, invalidating all tab pixmaps.
+    uint m_skinGeneration = 0;
+
+    // Corners and tiled background with the buttons cut out, along with
+    // everything its pixels depend on.
+    QPixmap m_backgroundPixmap;
+    uint m_backgroundSkinGeneration = 0;
+    QRect m_backgroundNewTabButtonGeometry;
+    QRect m_backgroundCloseTabButtonGeometry;
+
     int m_selectedSessionId;
 
     bool m_mousePressed;
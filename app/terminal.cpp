@@ -17,26 +17,121 @@
 
 #include <QAction>
 #include <QApplication>
+#include <QDir>
+#include <QFile>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QSplitter>
 #include <QWidget>
 
 #include <QKeyEvent>
 
 int Terminal::m_availableTerminalId = 0;
 
-Terminal::Terminal(const QString &workingDir, QWidget *parent)
+Terminal::Terminal(const QString &workingDir, QWidget *parent, bool deferred)
     : QObject(nullptr)
 {
     m_terminalId = m_availableTerminalId;
     m_availableTerminalId++;
     m_parentSplitter = parent;
+    m_workingDir = workingDir;
 
+    if (deferred) {
+        // Stand in for the part widget in the splitter until the terminal
+        // is shown or used for the first time.
+        m_placeholderWidget = new QWidget(parent);
+        m_partWidget = m_placeholderWidget;
+
+        return;
+    }
+
+    loadPart(parent);
+}
+
+Terminal::~Terminal()
+{
+    m_destroying = true;
+    // The ownership of m_part is a mess
+    // When the terminal exits, e.g. the user pressed Ctrl+D, the part deletes itself
+    // When we close a terminal we need to delete the part ourselves
+    if (m_part) {
+        delete m_part;
+    }
+
+    delete m_placeholderWidget;
+}
+
+void Terminal::materialize()
+{
+    if (!m_placeholderWidget)
+        return;
+
+    QWidget *placeholderWidget = m_placeholderWidget;
+    m_placeholderWidget = nullptr;
+
+    // Load without a parent, QSplitter::replaceWidget() refuses widgets
+    // that are already children of the splitter.
+    loadPart(nullptr);
+
+    QSplitter *splitter = qobject_cast<QSplitter *>(m_parentSplitter);
+    int index = splitter ? splitter->indexOf(placeholderWidget) : -1;
+
+    if (index != -1) {
+        splitter->replaceWidget(index, m_partWidget);
+    } else if (m_partWidget) {
+        m_partWidget->setParent(m_parentSplitter);
+    }
+
+    placeholderWidget->deleteLater();
+
+    Q_EMIT materialized(m_terminalId);
+}
+
+bool Terminal::canHibernate() const
+{
+    // Monitoring needs the part to stay around.
+    return isIdle() && !m_monitorActivityEnabled && !m_monitorSilenceEnabled;
+}
+
+void Terminal::hibernate()
+{
+    if (!m_part || isDeferred())
+        return;
+
+    // The shell comes back in the directory it was left in, as far as the
+    // profile lets it start elsewhere.
+    m_workingDir = currentWorkingDirectory();
+
+    QWidget *placeholderWidget = new QWidget(nullptr);
+
+    QSplitter *splitter = qobject_cast<QSplitter *>(m_parentSplitter);
+    int index = splitter ? splitter->indexOf(m_partWidget) : -1;
+
+    if (index != -1)
+        splitter->replaceWidget(index, placeholderWidget);
+    else
+        placeholderWidget->setParent(m_parentSplitter);
+
+    // Unloading isn't the shell exiting, don't have the terminal closed.
+    m_destroying = true;
+    delete m_part;
+    m_destroying = false;
+
+    delete findChild<KXMLGUIFactory *>(QString(), Qt::FindDirectChildrenOnly);
+
+    m_part = nullptr;
+    m_terminalInterface = nullptr;
+    m_placeholderWidget = placeholderWidget;
+    m_partWidget = placeholderWidget;
+}
+
+void Terminal::loadPart(QWidget *parent)
+{
     KPluginMetaData part(QStringLiteral("kf6/parts/konsolepart"));
 
     m_part = KParts::PartLoader::instantiatePart<KParts::Part>(part, parent).plugin;
     if (!m_part) {
-        displayKPartLoadError();
+        displayKPartLoadError(parent);
         return;
     }
 
@@ -80,10 +175,7 @@ Terminal::Terminal(const QString &workingDir, QWidget *parent)
         return;
     }
 
-    bool startInWorkingDir = m_terminalInterface->profileProperty(QStringLiteral("StartInCurrentSessionDir")).toBool();
-    if (startInWorkingDir && !workingDir.isEmpty()) {
-        m_terminalInterface->showShellInDir(workingDir);
-    }
+    showShellInDir(m_workingDir);
 
     QMetaObject::invokeMethod(m_part, "isBlurEnabled", Qt::DirectConnection, Q_RETURN_ARG(bool, m_wantsBlur));
 
@@ -98,17 +190,6 @@ Terminal::Terminal(const QString &workingDir, QWidget *parent)
     }
 }
 
-Terminal::~Terminal()
-{
-    m_destroying = true;
-    // The ownership of m_part is a mess
-    // When the terminal exits, e.g. the user pressed Ctrl+D, the part deletes itself
-    // When we close a terminal we need to delete the part ourselves
-    if (m_part) {
-        delete m_part;
-    }
-}
-
 bool Terminal::eventFilter(QObject * /* watched */, QEvent *event)
 {
     if (event->type() == QEvent::FocusIn) {
@@ -138,7 +219,7 @@ bool Terminal::eventFilter(QObject * /* watched */, QEvent *event)
     return false;
 }
 
-void Terminal::displayKPartLoadError()
+void Terminal::displayKPartLoadError(QWidget *parent)
 {
     KColorScheme colorScheme(QPalette::Active);
     QColor warningColor = colorScheme.background(KColorScheme::NeutralBackground).color();
@@ -147,7 +228,7 @@ void Terminal::displayKPartLoadError()
     gradient = gradient.arg(warningColor.name(), warningColorLight.name());
     QString styleSheet = QStringLiteral("QLabel { background: %1; }");
 
-    QWidget *widget = new QWidget(m_parentSplitter);
+    QWidget *widget = new QWidget(parent);
     widget->setStyleSheet(styleSheet.arg(gradient));
     m_partWidget = widget;
     m_terminalWidget = widget;
@@ -238,18 +319,107 @@ void Terminal::setTitle(const QString &title)
     Q_EMIT titleChanged(m_terminalId, m_title);
 }
 
+bool Terminal::startsInWorkingDir() const
+{
+    if (!m_terminalInterface)
+        return false;
+
+    return m_terminalInterface->profileProperty(QStringLiteral("StartInCurrentSessionDir")).toBool();
+}
+
+bool Terminal::canShowShellInDir(const QString &workingDir) const
+{
+    if (workingDir.isEmpty() || !startsInWorkingDir())
+        return true;
+
+    // Once the shell runs its working directory can no longer be changed.
+    if (m_terminalInterface->terminalProcessId() <= 0)
+        return true;
+
+    return QDir::cleanPath(currentWorkingDirectory()) == QDir::cleanPath(workingDir);
+}
+
+static bool hasChildProcesses(int processId)
+{
+#ifdef Q_OS_LINUX
+    // Children of the shell's main thread, shells don't start others.
+    QFile children(QStringLiteral("/proc/%1/task/%1/children").arg(processId));
+
+    // Without the file there is no telling, assume jobs.
+    if (!children.open(QIODevice::ReadOnly))
+        return true;
+
+    return !children.readAll().trimmed().isEmpty();
+#else
+    // Without a way to tell, assume the shell has jobs to look after.
+    Q_UNUSED(processId)
+
+    return true;
+#endif
+}
+
+bool Terminal::isIdle() const
+{
+    if (!m_part || !m_terminalInterface || isDeferred())
+        return false;
+
+    const int shellProcessId = m_terminalInterface->terminalProcessId();
+
+    if (shellProcessId <= 0 || m_terminalInterface->foregroundProcessId() != shellProcessId)
+        return false;
+
+    // Background and stopped jobs would otherwise live on hidden instead
+    // of being hung up on.
+    return !hasChildProcesses(shellProcessId);
+}
+
+void Terminal::reset()
+{
+    // A recycled terminal is a new terminal as far as sessions and D-Bus
+    // clients are concerned.
+    m_terminalId = m_availableTerminalId;
+    m_availableTerminalId++;
+
+    m_keyboardInputEnabled = true;
+
+    if (m_monitorActivityEnabled)
+        setMonitorActivityEnabled(false);
+
+    if (m_monitorSilenceEnabled)
+        setMonitorSilenceEnabled(false);
+
+    KActionCollection *collection = actionCollection();
+    QAction *action = collection ? collection->action(QStringLiteral("clear-history-and-reset")) : nullptr;
+
+    if (action)
+        action->trigger();
+}
+
+void Terminal::showShellInDir(const QString &workingDir)
+{
+    if (startsInWorkingDir() && !workingDir.isEmpty()) {
+        m_terminalInterface->showShellInDir(workingDir);
+    }
+}
+
 void Terminal::runCommand(const QString &command)
 {
+    materialize();
+
     m_terminalInterface->sendInput(command + QStringLiteral("\n"));
 }
 
 void Terminal::manageProfiles()
 {
+    materialize();
+
     QMetaObject::invokeMethod(m_part, "showManageProfilesDialog", Qt::QueuedConnection, Q_ARG(QWidget *, QApplication::activeWindow()));
 }
 
 void Terminal::editProfile()
 {
+    materialize();
+
     QMetaObject::invokeMethod(m_part, "showEditCurrentProfileDialog", Qt::QueuedConnection, Q_ARG(QWidget *, QApplication::activeWindow()));
 }
 
@@ -260,6 +430,8 @@ void Terminal::overrideShortcut(QKeyEvent * /* event */, bool &override)
 
 void Terminal::setMonitorActivityEnabled(bool enabled)
 {
+    materialize();
+
     m_monitorActivityEnabled = enabled;
 
     if (enabled) {
@@ -275,6 +447,8 @@ void Terminal::setMonitorActivityEnabled(bool enabled)
 
 void Terminal::setMonitorSilenceEnabled(bool enabled)
 {
+    materialize();
+
     m_monitorSilenceEnabled = enabled;
 
     if (enabled) {
@@ -300,12 +474,15 @@ void Terminal::silenceDetected()
 
 QString Terminal::currentWorkingDirectory() const
 {
+    if (!m_terminalInterface)
+        return m_workingDir;
+
     return m_terminalInterface->currentWorkingDirectory();
 }
 
 KActionCollection *Terminal::actionCollection()
 {
-    if (m_part->factory()) {
+    if (m_part && m_part->factory()) {
         const auto guiClients = m_part->childClients();
         for (auto *client : guiClients) {
             if (client->actionCollection()->associatedWidgets().contains(m_terminalWidget)) {
@@ -21,7 +21,7 @@ class Terminal : public QObject
     Q_OBJECT
 
 public:
-    explicit Terminal(const QString &workingDir, QWidget *parent = nullptr);
+    explicit Terminal(const QString &workingDir, QWidget *parent = nullptr, bool deferred = false);
     ~Terminal() override;
 
     bool eventFilter(QObject *watched, QEvent *event) override;
@@ -53,6 +53,24 @@ public:
         m_parentSplitter = splitter;
     }
 
+    bool isDeferred() const
+    {
+        return !m_placeholderWidget.isNull();
+    }
+    void materialize();
+
+    // Unloads the part of an idle terminal, putting the placeholder of a
+    // deferred terminal back in its place until it's used again.
+    bool canHibernate() const;
+    void hibernate();
+
+    bool canShowShellInDir(const QString &workingDir) const;
+    void showShellInDir(const QString &workingDir);
+
+    // Whether the shell sits at its prompt without any jobs.
+    bool isIdle() const;
+    void reset();
+
     void runCommand(const QString &command);
 
     void manageProfiles();
@@ -99,6 +117,7 @@ Q_SIGNALS:
     void silenceDetected(Terminal *terminal);
     void destroyed(int terminalId);
     void closeRequested(int terminalId);
+    void materialized(int terminalId);
 
 private Q_SLOTS:
     void setTitle(const QString &title);
@@ -107,9 +126,11 @@ private Q_SLOTS:
     void activityDetected();
 
 private:
+    void loadPart(QWidget *parent);
     void disableOffendingPartActions();
+    bool startsInWorkingDir() const;
 
-    void displayKPartLoadError();
+    void displayKPartLoadError(QWidget *parent);
 
     static int m_availableTerminalId;
     int m_terminalId;
@@ -119,7 +140,9 @@ private:
     QWidget *m_partWidget = nullptr;
     QPointer<QWidget> m_terminalWidget = nullptr;
     QWidget *m_parentSplitter;
+    QPointer<QWidget> m_placeholderWidget;
 
+    QString m_workingDir;
     QString m_title;
 
     bool m_keyboardInputEnabled = true;
@@ -0,0 +1,146 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "terminalpool.h"
+#include "settings.h"
+#include "terminal.h"
+
+#include <QWidget>
+
+#include <algorithm>
+
+TerminalPool::TerminalPool(QObject *parent)
+    : QObject(parent)
+    , m_holder(std::make_unique<QWidget>())
+{
+    m_holder->hide();
+
+    m_refillTimer.setSingleShot(true);
+    connect(&m_refillTimer, &QTimer::timeout, this, &TerminalPool::refill);
+
+    connect(Settings::self(), &Settings::configChanged, this, &TerminalPool::applySettings);
+
+    scheduleRefill();
+}
+
+TerminalPool::~TerminalPool()
+{
+    // The terminals have to go before the widget holding their parts.
+    m_terminals.clear();
+    m_recycledTerminals.clear();
+}
+
+std::unique_ptr<Terminal> TerminalPool::take(const QString &workingDir)
+{
+    auto canShowShellInDir = [&workingDir](const std::unique_ptr<Terminal> &terminal) {
+        return terminal->canShowShellInDir(workingDir);
+    };
+
+    // Recycled terminals only fit if their shell is in the right place already.
+    auto recycled = std::find_if(m_recycledTerminals.begin(), m_recycledTerminals.end(), canShowShellInDir);
+
+    if (recycled != m_recycledTerminals.end()) {
+        std::unique_ptr<Terminal> terminal = std::move(*recycled);
+        m_recycledTerminals.erase(recycled);
+
+        disconnect(terminal.get(), nullptr, this, nullptr);
+
+        return terminal;
+    }
+
+    auto it = std::find_if(m_terminals.begin(), m_terminals.end(), canShowShellInDir);
+
+    if (it == m_terminals.end())
+        return nullptr;
+
+    std::unique_ptr<Terminal> terminal = std::move(*it);
+    m_terminals.erase(it);
+
+    disconnect(terminal.get(), nullptr, this, nullptr);
+    terminal->showShellInDir(workingDir);
+
+    scheduleRefill();
+
+    return terminal;
+}
+
+bool TerminalPool::canRecycle(Terminal *terminal) const
+{
+    if (m_recycledTerminals.size() >= static_cast<std::size_t>(std::max(0, Settings::recycledTerminalLimit())))
+        return false;
+
+    return terminal && terminal->isIdle();
+}
+
+void TerminalPool::recycle(std::unique_ptr<Terminal> terminal)
+{
+    terminal->reset();
+
+    if (QWidget *partWidget = terminal->partWidget())
+        partWidget->setParent(m_holder.get());
+
+    terminal->setSplitter(m_holder.get());
+
+    connect(terminal.get(), &Terminal::closeRequested, this, &TerminalPool::discard);
+
+    m_recycledTerminals.push_back(std::move(terminal));
+}
+
+void TerminalPool::applySettings()
+{
+    const auto size = static_cast<std::size_t>(std::max(0, Settings::terminalPoolSize()));
+
+    if (m_terminals.size() > size)
+        m_terminals.resize(size);
+
+    const auto recycledLimit = static_cast<std::size_t>(std::max(0, Settings::recycledTerminalLimit()));
+
+    if (m_recycledTerminals.size() > recycledLimit)
+        m_recycledTerminals.resize(recycledLimit);
+
+    scheduleRefill();
+}
+
+void TerminalPool::scheduleRefill()
+{
+    if (m_terminals.size() >= static_cast<std::size_t>(std::max(0, Settings::terminalPoolSize()))) {
+        m_refillTimer.stop();
+        return;
+    }
+
+    // Restarting the timer on every take keeps refills out of bursts of
+    // session creation, e.g. when a script sets up a layout.
+    m_refillTimer.start(Settings::terminalPoolRefillDelay());
+}
+
+void TerminalPool::refill()
+{
+    if (m_terminals.size() >= static_cast<std::size_t>(std::max(0, Settings::terminalPoolSize())))
+        return;
+
+    std::unique_ptr<Terminal> terminal = std::make_unique<Terminal>(QString(), m_holder.get());
+    connect(terminal.get(), &Terminal::closeRequested, this, &TerminalPool::discard);
+
+    m_terminals.push_back(std::move(terminal));
+
+    // Build one terminal per event loop iteration to keep the GUI responsive.
+    if (m_terminals.size() < static_cast<std::size_t>(Settings::terminalPoolSize()))
+        m_refillTimer.start(0);
+}
+
+void TerminalPool::discard(int terminalId)
+{
+    auto hasId = [terminalId](const std::unique_ptr<Terminal> &terminal) {
+        return terminal->id() == terminalId;
+    };
+
+    std::erase_if(m_terminals, hasId);
+    std::erase_if(m_recycledTerminals, hasId);
+
+    scheduleRefill();
+}
+
+#include "moc_terminalpool.cpp"
@@ -0,0 +1,80 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef TERMINALPOOL_H
+#define TERMINALPOOL_H
+
+#include <QObject>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
+
+class Terminal;
+
+class QWidget;
+
+/**
+ * Keeps a number of hidden, fully constructed terminals around so that
+ * adding a session or splitting a terminal only has to reparent an
+ * already loaded Konsole part instead of instantiating a new one.
+ *
+ * Used slots are refilled one terminal at a time once the application
+ * has been idle for Settings::terminalPoolRefillDelay() milliseconds.
+ *
+ * Closed terminals whose shell sits idle at its prompt without any child
+ * processes are taken back as well, up to Settings::recycledTerminalLimit()
+ * of them, and handed out again for their working directory. Only the
+ * terminal is reset, the shell keeps running: its environment, aliases,
+ * shell history and anything else it was told carry over to the terminal
+ * it is handed out as.
+ */
+class TerminalPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TerminalPool(QObject *parent = nullptr);
+    ~TerminalPool() override;
+
+    /**
+     * Hands out a pooled terminal able to start its shell in @p workingDir,
+     * or returns nullptr if there is none. The caller is responsible for
+     * reparenting the terminal's part widget.
+     */
+    std::unique_ptr<Terminal> take(const QString &workingDir);
+
+    bool canRecycle(Terminal *terminal) const;
+
+    // Resets @p terminal and keeps it for reuse. The caller is responsible
+    // for disconnecting it and removing its part widget from the layout.
+    void recycle(std::unique_ptr<Terminal> terminal);
+
+    int count() const
+    {
+        return m_terminals.size();
+    }
+
+public Q_SLOTS:
+    void applySettings();
+
+private Q_SLOTS:
+    void refill();
+    void discard(int terminalId);
+
+private:
+    void scheduleRefill();
+
+    // Hidden parent for the part widgets of pooled terminals.
+    std::unique_ptr<QWidget> m_holder;
+
+    std::vector<std::unique_ptr<Terminal>> m_terminals;
+    std::vector<std::unique_ptr<Terminal>> m_recycledTerminals;
+
+    QTimer m_refillTimer;
+};
+
+#endif
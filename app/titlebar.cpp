@@ -220,9 +220,12 @@ QString TitleBar::title() const
 
 void TitleBar::setTitle(const QString &title)
 {
+    if (m_title == title)
+        return;
+
     m_title = title;
 
-    repaint();
+    update();
 }
 
 #include "moc_titlebar.cpp"
@@ -0,0 +1,128 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "workareacache.h"
+
+#include <KWindowInfo>
+
+WorkAreaCache::WorkAreaCache(QObject *parent)
+    : QObject(parent)
+{
+    connect(KX11Extras::self(), &KX11Extras::windowAdded, this, &WorkAreaCache::windowAdded);
+    connect(KX11Extras::self(), &KX11Extras::windowRemoved, this, &WorkAreaCache::windowRemoved);
+    connect(KX11Extras::self(), &KX11Extras::windowChanged, this, &WorkAreaCache::windowChanged);
+    connect(KX11Extras::self(), &KX11Extras::workAreaChanged, this, &WorkAreaCache::invalidate);
+    connect(KX11Extras::self(), &KX11Extras::currentDesktopChanged, this, &WorkAreaCache::invalidate);
+    connect(KX11Extras::self(), &KX11Extras::numberOfDesktopsChanged, this, &WorkAreaCache::invalidate);
+
+    // This is the only time all windows are looked at, from here on the
+    // strut windows are kept up to date through the signals above.
+    const QList<WId> windows = KX11Extras::windows();
+
+    for (WId windowId : windows)
+        updateWindow(windowId);
+}
+
+WorkAreaCache::~WorkAreaCache() = default;
+
+QRect WorkAreaCache::workArea(const QRect &screenGeometry)
+{
+    for (const auto &[geometry, workArea] : std::as_const(m_workAreas)) {
+        if (geometry == screenGeometry)
+            return workArea;
+    }
+
+    const int currentDesktop = KX11Extras::currentDesktop();
+    QList<WId> offScreenWindows;
+
+    for (auto it = m_strutWindows.cbegin(); it != m_strutWindows.cend(); ++it) {
+        const StrutWindow &window = it.value();
+
+        if (!window.onAllDesktops && window.desktop != currentDesktop)
+            continue;
+
+        const NETExtendedStrut &strut = window.strut;
+
+        // Get the area covered by each strut.
+        QRect topStrut(strut.top_start, 0, strut.top_end - strut.top_start, strut.top_width);
+        QRect bottomStrut(strut.bottom_start, screenGeometry.bottom() - strut.bottom_width, strut.bottom_end - strut.bottom_start, strut.bottom_width);
+        QRect leftStrut(0, strut.left_start, strut.left_width, strut.left_end - strut.left_start);
+        QRect rightStrut(screenGeometry.right() - strut.right_width, strut.right_start, strut.right_width, strut.right_end - strut.right_start);
+
+        if (topStrut.isEmpty() && bottomStrut.isEmpty() && leftStrut.isEmpty() && rightStrut.isEmpty())
+            continue;
+
+        // If any of the strut and the window itself intersects with our screen geometry,
+        // it will be correctly handled by workArea(). If the window doesn't intersect
+        // with our screen geometry it's most likely a plasma panel and can/should be
+        // ignored
+        if ((topStrut.intersects(screenGeometry) || bottomStrut.intersects(screenGeometry) || leftStrut.intersects(screenGeometry)
+             || rightStrut.intersects(screenGeometry))
+            && window.geometry.intersects(screenGeometry)) {
+            continue;
+        }
+
+        // This window has a strut on the same desktop as us but which does not cover our screen
+        // geometry. It should be ignored, otherwise the returned work area will wrongly include
+        // the strut.
+        offScreenWindows << it.key();
+    }
+
+    const QRect workArea = KX11Extras::workArea(offScreenWindows).intersected(screenGeometry);
+
+    m_workAreas.append({screenGeometry, workArea});
+
+    return workArea;
+}
+
+void WorkAreaCache::windowAdded(WId windowId)
+{
+    updateWindow(windowId);
+}
+
+void WorkAreaCache::windowRemoved(WId windowId)
+{
+    if (m_strutWindows.remove(windowId))
+        invalidate();
+}
+
+void WorkAreaCache::windowChanged(WId windowId, NET::Properties properties, NET::Properties2 properties2)
+{
+    if (properties2 & NET::WM2ExtendedStrut) {
+        updateWindow(windowId);
+    } else if (m_strutWindows.contains(windowId) && (properties & (NET::WMGeometry | NET::WMDesktop))) {
+        updateWindow(windowId);
+    }
+}
+
+void WorkAreaCache::invalidate()
+{
+    m_workAreas.clear();
+}
+
+void WorkAreaCache::updateWindow(WId windowId)
+{
+    KWindowInfo windowInfo(windowId, NET::WMDesktop | NET::WMGeometry, NET::WM2ExtendedStrut);
+
+    if (!windowInfo.valid()) {
+        windowRemoved(windowId);
+        return;
+    }
+
+    const NETExtendedStrut strut = windowInfo.extendedStrut();
+
+    // If the window has no strut, no need to bother further.
+    if (strut.top_width == 0 && strut.bottom_width == 0 && strut.left_width == 0 && strut.right_width == 0) {
+        windowRemoved(windowId);
+        return;
+    }
+
+    m_strutWindows.insert(windowId, {strut, windowInfo.geometry(), windowInfo.desktop(), windowInfo.onAllDesktops()});
+
+    invalidate();
+}
+
+#include "moc_workareacache.cpp"
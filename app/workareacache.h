@@ -0,0 +1,64 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#ifndef WORKAREACACHE_H
+#define WORKAREACACHE_H
+
+#include <KX11Extras>
+#include <netwm_def.h>
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QRect>
+
+/**
+ * Keeps track of the X11 windows reserving screen space (panels and
+ * the like) and the resulting per-screen work areas.
+ *
+ * The strut windows are tracked incrementally through KX11Extras'
+ * window signals, so computing the work area of a screen doesn't need
+ * to query every client window from the X server, and the result is
+ * cached until a strut, the current desktop or the global work area
+ * changes.
+ */
+class WorkAreaCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WorkAreaCache(QObject *parent = nullptr);
+    ~WorkAreaCache() override;
+
+    /**
+     * Returns the work area within @p screenGeometry, ignoring the struts
+     * of windows located on other screens.
+     */
+    QRect workArea(const QRect &screenGeometry);
+
+private Q_SLOTS:
+    void windowAdded(WId windowId);
+    void windowRemoved(WId windowId);
+    void windowChanged(WId windowId, NET::Properties properties, NET::Properties2 properties2);
+    void invalidate();
+
+private:
+    struct StrutWindow {
+        NETExtendedStrut strut;
+        QRect geometry;
+        int desktop;
+        bool onAllDesktops;
+    };
+
+    void updateWindow(WId windowId);
+
+    QHash<WId, StrutWindow> m_strutWindows;
+
+    // Computed work areas, keyed by the screen geometry they were computed for.
+    QList<std::pair<QRect, QRect>> m_workAreas;
+};
+
+#endif
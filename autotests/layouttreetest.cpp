@@ -0,0 +1,219 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "layouttree.h"
+
+#include <QTest>
+
+class LayoutTreeTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testRemoveLastTerminalOfNestedSplit();
+    void testRemoveLastTerminal();
+    void testCollapseSameOrientation();
+    void testCollapseIntoRoot();
+    void testNeighbors();
+    void testRebalanceEqual();
+    void testRebalanceWeighted();
+};
+
+void LayoutTreeTest::testRemoveLastTerminalOfNestedSplit()
+{
+    // 1 | (2 / (3))
+    LayoutTree tree;
+    LayoutTree::Node *root = tree.root();
+    tree.addTerminal(root, 1);
+    LayoutTree::Node *vertical = tree.addSplit(root, Qt::Vertical);
+    tree.addTerminal(vertical, 2);
+    LayoutTree::Node *horizontal = tree.addSplit(vertical, Qt::Horizontal);
+    tree.addTerminal(horizontal, 3);
+
+    std::vector<std::unique_ptr<LayoutTree::Node>> removedSplits;
+
+    // The split left empty goes, then the split left with terminal 2 alone.
+    QCOMPARE(tree.removeTerminal(3, removedSplits), root);
+    QCOMPARE(removedSplits.size(), size_t(2));
+    QCOMPARE(removedSplits.at(0).get(), horizontal);
+    QCOMPARE(removedSplits.at(1).get(), vertical);
+
+    QCOMPARE(tree.terminalIds(), QList<int>({1, 2}));
+    QCOMPARE(tree.terminalNode(3), nullptr);
+    QCOMPARE(root->children.size(), size_t(2));
+    QCOMPARE(tree.terminalNode(2)->parent, root);
+    QCOMPARE(root->children.at(1).get(), tree.terminalNode(2));
+}
+
+void LayoutTreeTest::testRemoveLastTerminal()
+{
+    LayoutTree tree;
+    tree.addTerminal(tree.root(), 1);
+
+    std::vector<std::unique_ptr<LayoutTree::Node>> removedSplits;
+
+    // The root stays around for the next terminal.
+    QCOMPARE(tree.removeTerminal(1, removedSplits), tree.root());
+    QVERIFY(removedSplits.empty());
+    QVERIFY(tree.root()->children.empty());
+    QVERIFY(tree.terminalIds().isEmpty());
+
+    QCOMPARE(tree.removeTerminal(1, removedSplits), nullptr);
+}
+
+void LayoutTreeTest::testCollapseSameOrientation()
+{
+    // 1 | (2 / (3 | 4))
+    LayoutTree tree;
+    LayoutTree::Node *root = tree.root();
+    tree.addTerminal(root, 1);
+    LayoutTree::Node *vertical = tree.addSplit(root, Qt::Vertical);
+    tree.addTerminal(vertical, 2);
+    LayoutTree::Node *horizontal = tree.addSplit(vertical, Qt::Horizontal);
+    tree.addTerminal(horizontal, 3);
+    tree.addTerminal(horizontal, 4);
+
+    root->sizes = {100, 200};
+    vertical->sizes = {50, 50};
+    horizontal->sizes = {30, 90};
+
+    std::vector<std::unique_ptr<LayoutTree::Node>> removedSplits;
+
+    // The vertical split is left with the horizontal one, which then ends
+    // up inside the horizontal root and is merged into it.
+    QCOMPARE(tree.removeTerminal(2, removedSplits), root);
+    QCOMPARE(removedSplits.size(), size_t(2));
+    QCOMPARE(removedSplits.at(0).get(), vertical);
+    QCOMPARE(removedSplits.at(1).get(), horizontal);
+    QVERIFY(removedSplits.at(1)->children.empty());
+
+    QCOMPARE(tree.terminalIds(), QList<int>({1, 3, 4}));
+    QCOMPARE(root->orientation, Qt::Horizontal);
+    QCOMPARE(root->children.size(), size_t(3));
+
+    for (const std::unique_ptr<LayoutTree::Node> &child : root->children) {
+        QVERIFY(child->isTerminal());
+        QCOMPARE(child->parent, root);
+    }
+
+    // The merged split's space is shared out as it was before.
+    QCOMPARE(root->sizes, QList<int>({100, 50, 150}));
+}
+
+void LayoutTreeTest::testCollapseIntoRoot()
+{
+    // 1 | (2 / 3)
+    LayoutTree tree;
+    LayoutTree::Node *root = tree.root();
+    tree.addTerminal(root, 1);
+    LayoutTree::Node *vertical = tree.addSplit(root, Qt::Vertical);
+    tree.addTerminal(vertical, 2);
+    tree.addTerminal(vertical, 3);
+
+    vertical->sizes = {40, 60};
+
+    std::vector<std::unique_ptr<LayoutTree::Node>> removedSplits;
+
+    // The root takes over the children of its only remaining child.
+    QCOMPARE(tree.removeTerminal(1, removedSplits), root);
+    QCOMPARE(removedSplits.size(), size_t(1));
+    QCOMPARE(removedSplits.at(0).get(), vertical);
+
+    QCOMPARE(root->orientation, Qt::Vertical);
+    QCOMPARE(root->sizes, QList<int>({40, 60}));
+    QCOMPARE(tree.terminalIds(), QList<int>({2, 3}));
+    QCOMPARE(tree.terminalNode(2)->parent, root);
+    QCOMPARE(tree.terminalNode(3)->parent, root);
+}
+
+void LayoutTreeTest::testNeighbors()
+{
+    // +---+-------+
+    // |   |   2   |
+    // | 1 +---+---+
+    // |   | 3 | 4 |
+    // +---+---+---+
+    LayoutTree tree;
+    LayoutTree::Node *root = tree.root();
+    tree.addTerminal(root, 1);
+    LayoutTree::Node *vertical = tree.addSplit(root, Qt::Vertical);
+    tree.addTerminal(vertical, 2);
+    LayoutTree::Node *horizontal = tree.addSplit(vertical, Qt::Horizontal);
+    tree.addTerminal(horizontal, 3);
+    tree.addTerminal(horizontal, 4);
+
+    const QHash<int, LayoutTree::Neighbors> neighbors = tree.neighbors();
+
+    QCOMPARE(neighbors.size(), qsizetype(4));
+
+    // Terminal 3 faces the middle of 1's right edge, 4 that of 2's bottom.
+    QCOMPARE(neighbors.value(1).up, -1);
+    QCOMPARE(neighbors.value(1).right, 3);
+    QCOMPARE(neighbors.value(1).down, -1);
+    QCOMPARE(neighbors.value(1).left, -1);
+
+    QCOMPARE(neighbors.value(2).up, -1);
+    QCOMPARE(neighbors.value(2).right, -1);
+    QCOMPARE(neighbors.value(2).down, 4);
+    QCOMPARE(neighbors.value(2).left, 1);
+
+    QCOMPARE(neighbors.value(3).up, 2);
+    QCOMPARE(neighbors.value(3).right, 4);
+    QCOMPARE(neighbors.value(3).down, -1);
+    QCOMPARE(neighbors.value(3).left, 1);
+
+    QCOMPARE(neighbors.value(4).up, 2);
+    QCOMPARE(neighbors.value(4).right, -1);
+    QCOMPARE(neighbors.value(4).down, -1);
+    QCOMPARE(neighbors.value(4).left, 3);
+}
+
+void LayoutTreeTest::testRebalanceEqual()
+{
+    // 1 | (2 / (3 | 4))
+    LayoutTree tree;
+    LayoutTree::Node *root = tree.root();
+    tree.addTerminal(root, 1);
+    LayoutTree::Node *vertical = tree.addSplit(root, Qt::Vertical);
+    tree.addTerminal(vertical, 2);
+    LayoutTree::Node *horizontal = tree.addSplit(vertical, Qt::Horizontal);
+    tree.addTerminal(horizontal, 3);
+    tree.addTerminal(horizontal, 4);
+
+    tree.rebalance(LayoutTree::Equal);
+
+    // Terminals 1, 3 and 4 sit side by side, so each gets a third of the width.
+    QCOMPARE(root->sizes, QList<int>({3333, 6667}));
+    QCOMPARE(vertical->sizes, QList<int>({5000, 5000}));
+    QCOMPARE(horizontal->sizes, QList<int>({5000, 5000}));
+}
+
+void LayoutTreeTest::testRebalanceWeighted()
+{
+    // 1 | (2 / 3)
+    LayoutTree tree;
+    LayoutTree::Node *root = tree.root();
+    tree.addTerminal(root, 1);
+    LayoutTree::Node *vertical = tree.addSplit(root, Qt::Vertical);
+    tree.addTerminal(vertical, 2);
+    tree.addTerminal(vertical, 3);
+
+    tree.rebalance(LayoutTree::Weighted, -1, {{1, 2.0}, {2, 1.0}, {3, 3.0}});
+
+    // The vertical split is as wide as its widest terminal.
+    QCOMPARE(root->sizes, QList<int>({4000, 6000}));
+    QCOMPARE(vertical->sizes, QList<int>({2500, 7500}));
+
+    // Terminals without a weight, or a weight that isn't positive, count as 1.
+    tree.rebalance(LayoutTree::Weighted, -1, {{2, -1.0}, {3, 3.0}});
+
+    QCOMPARE(root->sizes, QList<int>({2500, 7500}));
+    QCOMPARE(vertical->sizes, QList<int>({2500, 7500}));
+}
+
+QTEST_GUILESS_MAIN(LayoutTreeTest)
+
+#include "layouttreetest.moc"
@@ -0,0 +1,140 @@
+/*
+  SPDX-FileCopyrightText: 2026 The Yakuake Team
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "mainwindow.h"
+#include "sessionstack.h"
+#include "settings.h"
+#include "tabbar.h"
+
+#include <QStandardPaths>
+#include <QTest>
+
+class TabBarBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testCachedPaintMatchesUncached();
+
+    void benchmarkPaint_data();
+    void benchmarkPaint();
+
+private:
+    void invalidateCache();
+
+    MainWindow *m_mainWindow = nullptr;
+    TabBar *m_tabBar = nullptr;
+    QList<int> m_sessionIds;
+};
+
+void TabBarBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication::setApplicationName(QStringLiteral("yakuake"));
+
+    // Use the skins from the source tree rather than an installed copy.
+    qputenv("XDG_DATA_DIRS", QByteArrayLiteral(YAKUAKE_TEST_DATA_DIR ":") + qgetenv("XDG_DATA_DIRS"));
+
+    Settings::setFirstRun(false);
+    Settings::setPollMouse(false);
+    Settings::setRestoreSessions(false);
+    Settings::setSkin(QStringLiteral("default"));
+    Settings::setSkinInstalledWithKns(false);
+
+    // Only the tabs matter, don't load any terminals.
+    Settings::setDeferTerminalLoading(true);
+
+    m_mainWindow = new MainWindow();
+    m_tabBar = m_mainWindow->findChild<TabBar *>();
+    QVERIFY(m_tabBar);
+
+    SessionStack *sessionStack = m_mainWindow->sessionStack();
+
+    while (sessionStack->sessionIds().count() < 30)
+        sessionStack->addSession();
+
+    m_sessionIds = sessionStack->sessionIds();
+
+    // Wide enough for all tabs, with one in the middle selected.
+    m_tabBar->resize(4000, m_tabBar->height());
+    sessionStack->raiseSession(m_sessionIds.at(15));
+}
+
+void TabBarBenchmark::cleanupTestCase()
+{
+    delete m_mainWindow;
+}
+
+void TabBarBenchmark::invalidateCache()
+{
+    // Like a change of fonts or skin, every tab and the background have
+    // to be measured and rendered anew.
+    QEvent fontChange(QEvent::FontChange);
+    QCoreApplication::sendEvent(m_tabBar, &fontChange);
+}
+
+void TabBarBenchmark::testCachedPaintMatchesUncached()
+{
+    m_tabBar->grab();
+    const QImage cached = m_tabBar->grab().toImage();
+
+    invalidateCache();
+    const QImage uncached = m_tabBar->grab().toImage();
+
+    QCOMPARE(cached, uncached);
+
+    // Title and selection changes have to make it past the cache.
+    m_tabBar->setTabTitleAutomated(m_sessionIds.at(3), QStringLiteral("Changed title"));
+    const QImage retitled = m_tabBar->grab().toImage();
+
+    QVERIFY(retitled != uncached);
+
+    invalidateCache();
+    QCOMPARE(m_tabBar->grab().toImage(), retitled);
+
+    m_mainWindow->sessionStack()->raiseSession(m_sessionIds.at(16));
+    const QImage reselected = m_tabBar->grab().toImage();
+
+    QVERIFY(reselected != retitled);
+
+    invalidateCache();
+    QCOMPARE(m_tabBar->grab().toImage(), reselected);
+
+    m_mainWindow->sessionStack()->raiseSession(m_sessionIds.at(15));
+}
+
+void TabBarBenchmark::benchmarkPaint_data()
+{
+    QTest::addColumn<bool>("cached");
+
+    QTest::newRow("cached") << true;
+    QTest::newRow("uncached") << false;
+}
+
+void TabBarBenchmark::benchmarkPaint()
+{
+    QFETCH(bool, cached);
+
+    int frame = 0;
+
+    QBENCHMARK {
+        // Shells keep updating their titles, one tab changes every frame.
+        m_tabBar->setTabTitleAutomated(m_sessionIds.at(frame % m_sessionIds.count()), QStringLiteral("~/src: make %1").arg(frame));
+        ++frame;
+
+        if (!cached)
+            invalidateCache();
+
+        m_tabBar->grab();
+    }
+}
+
+QTEST_MAIN(TabBarBenchmark)
+
+#include "tabbarbenchmark.moc"